@@ -4,6 +4,99 @@
 
 Bitboard PseudoAttacks[PIECE_TYPE_NB][SQ_NB];
 Bitboard PawnAttacks[COLOR_NB][SQ_NB];
+Bitboard BetweenBB[SQ_NB][SQ_NB];
+
+Magic RookMagics[SQ_NB];
+Magic BishopMagics[SQ_NB];
+
+namespace {
+
+Bitboard RookTable[0x19000];  // Sum of 2^popcount(mask) over the squares
+Bitboard BishopTable[0x1480];
+
+// xorshift64* generator, only used to find the magic numbers
+struct PRNG {
+	uint64_t s;
+	explicit PRNG(uint64_t seed) : s(seed) {}
+	uint64_t rand() {
+		s ^= s >> 12, s ^= s << 25, s ^= s >> 27;
+		return s * 2685821657736338717ULL;
+	}
+	// Magics with few bits set are found faster
+	uint64_t sparse_rand() { return rand() & rand() & rand(); }
+};
+
+// Find a magic number for each square by trial and error, and fill the
+// attack tables. The seeds are known to find magics quickly.
+void init_magics(PieceType pt, Bitboard table[], Magic magics[]) {
+	constexpr uint64_t Seeds[RANK_NB] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+	Bitboard occupancy[4096], reference[4096];
+	int epoch[4096] = {}, cnt = 0;
+
+	for (int s = 0; s < SQ_NB; ++s) {
+		Square sq = Square(s);
+		Magic& m = magics[s];
+
+		// Edges are not relevant, a ray always ends there
+		Bitboard edges = ((RankMask[RANK_1] | RankMask[RANK_8]) & ~RankMask[get_rank(sq)])
+		               | ((FileMask[FILE_A] | FileMask[FILE_H]) & ~FileMask[get_file(sq)]);
+		m.mask = sliding_attack(pt, sq, 0) & ~edges;
+		m.shift = 64 - __builtin_popcountll(m.mask);
+		m.attacks = s == SQ_A1 ? table : magics[s - 1].attacks + (1 << (64 - magics[s - 1].shift));
+
+		// Enumerate the subsets of the mask (Carry-Rippler trick)
+		int size = 0;
+		Bitboard b = 0;
+		do {
+			occupancy[size] = b;
+			reference[size] = sliding_attack(pt, sq, b);
+			++size;
+			b = (b - m.mask) & m.mask;
+		} while (b);
+
+		PRNG rng(Seeds[get_rank(sq)]);
+		for (int i = 0; i < size; ) {
+			for (m.magic = 0; __builtin_popcountll((m.magic * m.mask) >> 56) < 6; ) {
+				m.magic = rng.sparse_rand();
+			}
+
+			// The epoch avoids clearing the table for each candidate magic
+			++cnt;
+			for (i = 0; i < size; ++i) {
+				unsigned idx = m.index(occupancy[i]);
+				if (epoch[idx] < cnt) {
+					epoch[idx] = cnt;
+					m.attacks[idx] = reference[i];
+				}
+				else if (m.attacks[idx] != reference[i]) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+}
+
+Bitboard sliding_attack(PieceType pt, Square sq, Bitboard occupied) {
+	static const int rook_dirs[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+	static const int bishop_dirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+	const int (*dirs)[2] = (pt == ROOK) ? rook_dirs : bishop_dirs;
+
+	Bitboard b = 0;
+	for (int i = 0; i < 4; ++i) {
+		int f = get_file(sq) + dirs[i][0];
+		int r = get_rank(sq) + dirs[i][1];
+		while (f >= FILE_A && f <= FILE_H && r >= RANK_1 && r <= RANK_8) {
+			Square s = make_square(File(f), Rank(r));
+			b |= square_bb(s);
+			if (occupied & square_bb(s)) break;
+			f += dirs[i][0];
+			r += dirs[i][1];
+		}
+	}
+	return b;
+}
 
 namespace bitboard {
 
@@ -39,6 +132,26 @@ void init() {
 		// Black pawns capture SouthEast (+1, -1) and SouthWest (-1, -1)
 		PawnAttacks[BLACK][s] |= safe_step(sq, 1, -1);
 		PawnAttacks[BLACK][s] |= safe_step(sq, -1, -1);
+
+		// 4. Sliders on an empty board
+		PseudoAttacks[BISHOP][s] = sliding_attack(BISHOP, sq, 0);
+		PseudoAttacks[ROOK][s] = sliding_attack(ROOK, sq, 0);
+		PseudoAttacks[QUEEN][s] = PseudoAttacks[BISHOP][s] | PseudoAttacks[ROOK][s];
+	}
+
+	init_magics(ROOK, RookTable, RookMagics);
+	init_magics(BISHOP, BishopTable, BishopMagics);
+
+	memset(BetweenBB, 0, sizeof(BetweenBB));
+	for (int s1 = 0; s1 < SQ_NB; ++s1) {
+		for (PieceType pt : { BISHOP, ROOK }) {
+			for (int s2 = 0; s2 < SQ_NB; ++s2) {
+				if (PseudoAttacks[pt][s1] & square_bb(Square(s2))) {
+					BetweenBB[s1][s2] = sliding_attack(pt, Square(s1), square_bb(Square(s2)))
+					                  & sliding_attack(pt, Square(s2), square_bb(Square(s1)));
+				}
+			}
+		}
 	}
 }
 
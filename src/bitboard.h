@@ -1,93 +1,247 @@
-#ifndef BITBOARD_H_INCLUDED
-#define BITBOARD_H_INCLUDED
-
-#include "types.h"
-#include <cassert>
-
-// 0x0101010101010101 is File A, shifted left for B, C, etc.
-constexpr Bitboard FileMask[FILE_NB] = {
-	0x0101010101010101ULL, 0x0202020202020202ULL, 
-	0x0404040404040404ULL, 0x0808080808080808ULL, 
-	0x1010101010101010ULL, 0x2020202020202020ULL, 
-	0x4040404040404040ULL, 0x8080808080808080ULL
-};
-
-// 0xFF is Rank 1, shifted left for Rank 2, 3, etc.
-constexpr Bitboard RankMask[RANK_NB] = {
-	0x00000000000000FFULL, 0x000000000000FF00ULL, 
-	0x0000000000FF0000ULL, 0x00000000FF000000ULL, 
-	0x000000FF00000000ULL, 0x0000FF0000000000ULL, 
-	0x00FF000000000000ULL, 0xFF00000000000000ULL
-};
-
-// --- THÊM ĐOẠN NÀY ĐỂ HỖ TRỢ WINDOWS (MSVC) ---
-#ifdef _MSC_VER
-#include <intrin.h>
-#pragma intrinsic(_BitScanForward64)
-#pragma intrinsic(__popcnt)
-#pragma intrinsic(__popcnt64)
-
-// Định nghĩa lại các hàm của Linux sang Windows
-inline int __builtin_ctzll(unsigned long long mask) {
-    unsigned long index;
-    if (_BitScanForward64(&index, mask))
-        return (int)index;
-    return 0;
-}
-
-#define __builtin_popcount __popcnt
-#define __builtin_popcountll __popcnt64
-#endif
-// ----------------------------------------------
-
-#define act_bit(b, i) do { (b) |= 1ULL << (i); } while(0)
-#define dec_bit(b, i) do { (b) &= ~(1ULL << (i)); } while (0)
-#define hav_bit(b, i) ((b) & (1ULL << (i)))
-
-inline Square lsb(Bitboard b) {
-#ifdef _MSC_VER
-    unsigned long index;
-    if (_BitScanForward64(&index, b))
-        return Square(index);
-    return SQ_NONE; // Or handle 0 case
-#else
-    return Square(__builtin_ctzll(b));
-#endif
-}
-
-inline Square pop_lsb(Bitboard& b) {
-	Square s = lsb(b);
-	b &= b - 1;
-	return s;
-}
-
-constexpr Bitboard square_bb(Square sq) {
-	return 1ULL << sq;
-}
-
-constexpr Bitboard path_bb(Square from, Square to) {
-	Bitboard b = 0;
-	int f_from = get_file(from);
-	int r_from = get_rank(from);
-	int f_to = get_file(to);
-	int r_to = get_rank(to);
-	assert(f_from == f_to || r_from == r_to);
-	while (true) {
-		b |= 1ULL << make_square(File(f_from), Rank(r_from));
-		if (f_from < f_to) ++f_from;
-		else if (f_from > f_to) --f_from;
-		else if (r_from < r_to) ++r_from;
-		else if (r_from > r_to) --r_from;
-		else break;
-	}
-	return b;
-}
-
-extern Bitboard PseudoAttacks[PIECE_TYPE_NB][SQ_NB];
-extern Bitboard PawnAttacks[COLOR_NB][SQ_NB];
-
-namespace bitboard {
-	void init();
-}
-
-#endif
+#ifndef BITBOARD_H_INCLUDED
+#define BITBOARD_H_INCLUDED
+
+#include "types.h"
+#include <array>
+#include <cassert>
+
+// 0x0101010101010101 is File A, shifted left for B, C, etc.
+constexpr Bitboard FileMask[FILE_NB] = {
+	0x0101010101010101ULL, 0x0202020202020202ULL, 
+	0x0404040404040404ULL, 0x0808080808080808ULL, 
+	0x1010101010101010ULL, 0x2020202020202020ULL, 
+	0x4040404040404040ULL, 0x8080808080808080ULL
+};
+
+// 0xFF is Rank 1, shifted left for Rank 2, 3, etc.
+constexpr Bitboard RankMask[RANK_NB] = {
+	0x00000000000000FFULL, 0x000000000000FF00ULL, 
+	0x0000000000FF0000ULL, 0x00000000FF000000ULL, 
+	0x000000FF00000000ULL, 0x0000FF0000000000ULL, 
+	0x00FF000000000000ULL, 0xFF00000000000000ULL
+};
+
+// Squares of the same color as A1
+constexpr Bitboard DarkSquares = 0xAA55AA55AA55AA55ULL;
+
+// --- THÊM ĐOẠN NÀY ĐỂ HỖ TRỢ WINDOWS (MSVC) ---
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_BitScanForward64)
+#pragma intrinsic(__popcnt)
+#pragma intrinsic(__popcnt64)
+
+// Định nghĩa lại các hàm của Linux sang Windows
+inline int __builtin_ctzll(unsigned long long mask) {
+    unsigned long index;
+    if (_BitScanForward64(&index, mask))
+        return (int)index;
+    return 0;
+}
+
+#define __builtin_popcount __popcnt
+#define __builtin_popcountll __popcnt64
+#endif
+// ----------------------------------------------
+
+#define act_bit(b, i) do { (b) |= 1ULL << (i); } while(0)
+#define dec_bit(b, i) do { (b) &= ~(1ULL << (i)); } while (0)
+#define hav_bit(b, i) ((b) & (1ULL << (i)))
+
+inline Square lsb(Bitboard b) {
+#ifdef _MSC_VER
+    unsigned long index;
+    if (_BitScanForward64(&index, b))
+        return Square(index);
+    return SQ_NONE; // Or handle 0 case
+#else
+    return Square(__builtin_ctzll(b));
+#endif
+}
+
+inline Square pop_lsb(Bitboard& b) {
+	Square s = lsb(b);
+	b &= b - 1;
+	return s;
+}
+
+constexpr Bitboard square_bb(Square sq) {
+	return 1ULL << sq;
+}
+
+constexpr Bitboard path_bb(Square from, Square to) {
+	Bitboard b = 0;
+	int f_from = get_file(from);
+	int r_from = get_rank(from);
+	int f_to = get_file(to);
+	int r_to = get_rank(to);
+	assert(f_from == f_to || r_from == r_to);
+	while (true) {
+		b |= 1ULL << make_square(File(f_from), Rank(r_from));
+		if (f_from < f_to) ++f_from;
+		else if (f_from > f_to) --f_from;
+		else if (r_from < r_to) ++r_from;
+		else if (r_from > r_to) --r_from;
+		else break;
+	}
+	return b;
+}
+
+inline Bitboard file_bb(File f) { return FileMask[f]; }
+inline Bitboard rank_bb(Rank r) { return RankMask[r]; }
+
+// Pawn structure tables, computed at compile time
+
+// Files next to a file
+constexpr std::array<Bitboard, FILE_NB> AdjacentFilesBB = [] {
+	std::array<Bitboard, FILE_NB> t{};
+	for (int f = FILE_A; f <= FILE_H; ++f) {
+		t[f] = (f > FILE_A ? FileMask[f - 1] : 0) | (f < FILE_H ? FileMask[f + 1] : 0);
+	}
+	return t;
+}();
+
+// Ranks strictly in front of a rank, from the point of view of a color
+constexpr std::array<std::array<Bitboard, RANK_NB>, COLOR_NB> ForwardRanksBB = [] {
+	std::array<std::array<Bitboard, RANK_NB>, COLOR_NB> t{};
+	for (int r = RANK_1; r <= RANK_8; ++r) {
+		for (int i = r + 1; i < RANK_NB; ++i) t[WHITE][r] |= RankMask[i];
+		for (int i = r - 1; i >= RANK_1; --i) t[BLACK][r] |= RankMask[i];
+	}
+	return t;
+}();
+
+// Squares in front of a square on its file
+constexpr std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> ForwardFileBB = [] {
+	std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> t{};
+	for (int c = WHITE; c <= BLACK; ++c) {
+		for (int s = 0; s < SQ_NB; ++s) t[c][s] = ForwardRanksBB[c][s / 8] & FileMask[s % 8];
+	}
+	return t;
+}();
+
+// Squares which a pawn on a square can attack as it advances
+constexpr std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> PawnAttackSpan = [] {
+	std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> t{};
+	for (int c = WHITE; c <= BLACK; ++c) {
+		for (int s = 0; s < SQ_NB; ++s) t[c][s] = ForwardRanksBB[c][s / 8] & AdjacentFilesBB[s % 8];
+	}
+	return t;
+}();
+
+// A pawn is passed if no enemy pawn is on these squares
+constexpr std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> PassedPawnMask = [] {
+	std::array<std::array<Bitboard, SQ_NB>, COLOR_NB> t{};
+	for (int c = WHITE; c <= BLACK; ++c) {
+		for (int s = 0; s < SQ_NB; ++s) t[c][s] = ForwardFileBB[c][s] | PawnAttackSpan[c][s];
+	}
+	return t;
+}();
+
+inline Bitboard adjacent_files_bb(File f) { return AdjacentFilesBB[f]; }
+
+// Move all the squares of a bitboard one step, dropping those which
+// leave the board
+template<Direction D>
+constexpr Bitboard shift(Bitboard b) {
+	return D == NORTH      ?  b << 8
+	     : D == SOUTH      ?  b >> 8
+	     : D == EAST       ? (b & ~FileMask[FILE_H]) << 1
+	     : D == WEST       ? (b & ~FileMask[FILE_A]) >> 1
+	     : D == NORTH_EAST ? (b & ~FileMask[FILE_H]) << 9
+	     : D == NORTH_WEST ? (b & ~FileMask[FILE_A]) << 7
+	     : D == SOUTH_EAST ? (b & ~FileMask[FILE_H]) >> 7
+	     : D == SOUTH_WEST ? (b & ~FileMask[FILE_A]) >> 9
+	     : 0;
+}
+
+// Kogge-Stone fills: every square of b smeared to the edge of its file
+constexpr Bitboard north_fill(Bitboard b) {
+	b |= b << 8;
+	b |= b << 16;
+	return b | (b << 32);
+}
+
+constexpr Bitboard south_fill(Bitboard b) {
+	b |= b >> 8;
+	b |= b >> 16;
+	return b | (b >> 32);
+}
+
+constexpr Bitboard file_fill(Bitboard b) {
+	return north_fill(b) | south_fill(b);
+}
+
+// Squares strictly in front of the squares of b, from the point of view of c
+constexpr Bitboard front_span(Color c, Bitboard b) {
+	return c == WHITE ? north_fill(b) << 8 : south_fill(b) >> 8;
+}
+
+// Squares attacked by the pawns of color c in b
+constexpr Bitboard pawn_attacks_bb(Color c, Bitboard b) {
+	return c == WHITE ? shift<NORTH_WEST>(b) | shift<NORTH_EAST>(b)
+	                  : shift<SOUTH_WEST>(b) | shift<SOUTH_EAST>(b);
+}
+
+// Number of king moves between two squares
+inline int square_distance(Square a, Square b) {
+	int df = distance(get_file(a), get_file(b));
+	int dr = distance(get_rank(a), get_rank(b));
+	return df > dr ? df : dr;
+}
+
+inline bool more_than_one(Bitboard b) {
+	return b & (b - 1);
+}
+
+// Are the two squares of different colors?
+inline bool opposite_colors(Square a, Square b) {
+	return ((get_file(a) + get_rank(a)) ^ (get_file(b) + get_rank(b))) & 1;
+}
+
+extern Bitboard PseudoAttacks[PIECE_TYPE_NB][SQ_NB];
+extern Bitboard PawnAttacks[COLOR_NB][SQ_NB];
+
+// Squares strictly between two squares on a same line, 0 if not aligned
+extern Bitboard BetweenBB[SQ_NB][SQ_NB];
+
+namespace bitboard {
+	void init();
+}
+
+// Attacks of a bishop or a rook on sq, the rays stop at the first
+// occupied square (included). Slow, used to fill the magic tables.
+Bitboard sliding_attack(PieceType pt, Square sq, Bitboard occupied);
+
+// Magic bitboards: the relevant occupancy of a slider (the squares of its
+// rays without the edges) is hashed by a multiplication with a magic
+// number into an index of its attack table
+struct Magic {
+	Bitboard mask;
+	Bitboard magic;
+	Bitboard* attacks;
+	unsigned shift;
+
+	unsigned index(Bitboard occupied) const {
+		return unsigned(((occupied & mask) * magic) >> shift);
+	}
+};
+
+extern Magic RookMagics[SQ_NB];
+extern Magic BishopMagics[SQ_NB];
+
+// Attacks of a piece of type pt (not a pawn) on sq given the occupancy
+inline Bitboard attacks_bb(PieceType pt, Square sq, Bitboard occupied) {
+	switch (pt) {
+		case BISHOP:
+			return BishopMagics[sq].attacks[BishopMagics[sq].index(occupied)];
+		case ROOK:
+			return RookMagics[sq].attacks[RookMagics[sq].index(occupied)];
+		case QUEEN:
+			return attacks_bb(BISHOP, sq, occupied) | attacks_bb(ROOK, sq, occupied);
+		default:
+			return PseudoAttacks[pt][sq];
+	}
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "endgame.h"
+#include "bitboard.h"
+#include "position.h"
+#include "types.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+std::unordered_map<Key, Endgames::Endgame> Registry;
+
+// Lone king against mating material, for each strong side
+Endgames::Endgame EndgameKXK[COLOR_NB];
+
+// Bonus for driving the weak king to the edge of the board
+int push_to_edge(Square s) {
+	int rd = std::min(int(get_rank(s)), int(RANK_8) - int(get_rank(s)));
+	int fd = std::min(int(get_file(s)), int(FILE_H) - int(get_file(s)));
+	return 90 - (7 * fd * fd / 2 + 7 * rd * rd / 2);
+}
+
+// Bonus for driving the weak king to a corner of the A1-H8 diagonal
+int push_to_corner(Square s) {
+	return std::abs(7 - int(get_rank(s)) - int(get_file(s)));
+}
+
+// Bonus for keeping two pieces close, or apart
+int push_close(Square a, Square b) { return 140 - 20 * square_distance(a, b); }
+int push_away(Square a, Square b) { return 120 - push_close(a, b); }
+
+Square king_square(const Position& pos, Color c) {
+	return lsb(pos.pieces(c, KING));
+}
+
+// Is the lone king of c stalemated: not in check, and without a square
+// which is not attacked? Sliders see through the king, which moves away.
+bool lone_king_stalemated(const Position& pos, Color c) {
+	Square ksq = king_square(pos, c);
+	Bitboard them = pos.pieces(flip_color(c));
+	Bitboard occupied = pos.pieces() ^ square_bb(ksq);
+	if (pos.attackers_to(ksq, pos.pieces()) & them) return false;
+
+	for (Bitboard b = PseudoAttacks[KING][ksq] & ~pos.pieces(c); b; ) {
+		if (!(pos.attackers_to(pop_lsb(b), occupied) & them)) return false;
+	}
+	return true;
+}
+
+// Mate with enough material against a lone king: drive the king to the
+// edge and bring ours closer
+Value evaluate_KXK(const Position& pos, Color strongSide) {
+	Color weakSide = flip_color(strongSide);
+	Square strongKing = king_square(pos, strongSide);
+	Square weakKing = king_square(pos, weakSide);
+
+	// A stand pat must not score a stalemate as a win
+	if (pos.side_to_move() == weakSide && lone_king_stalemated(pos, weakSide)) {
+		return VALUE_DRAW;
+	}
+
+	Value result = Value(pos.non_pawn_material(strongSide)
+	                   + pos.count(make_piece(strongSide, PAWN)) * PawnValueEg
+	                   + push_to_edge(weakKing)
+	                   + push_close(strongKing, weakKing));
+
+	Bitboard bishops = pos.pieces(strongSide, BISHOP);
+	if (pos.pieces(strongSide, QUEEN) || pos.pieces(strongSide, ROOK)
+	    || (bishops && pos.pieces(strongSide, KNIGHT))
+	    || ((bishops & DarkSquares) && (bishops & ~DarkSquares))) {
+		result = std::min(result + VALUE_KNOWN_WIN, Value(VALUE_MATE_IN_MAX_PLY - 1));
+	}
+	return result;
+}
+
+// Bishop and knight: the king has to be driven to a corner of the color
+// of the bishop
+Value evaluate_KBNK(const Position& pos, Color strongSide) {
+	Color weakSide = flip_color(strongSide);
+	Square strongKing = king_square(pos, strongSide);
+	Square weakKing = king_square(pos, weakSide);
+	Square bishopSq = lsb(pos.pieces(strongSide, BISHOP));
+
+	// push_to_corner() targets A1 and H8, mirror the board for a light bishop
+	if (opposite_colors(bishopSq, SQ_A1)) {
+		weakKing = make_square(File(FILE_H - get_file(weakKing)), get_rank(weakKing));
+	}
+
+	return Value(VALUE_KNOWN_WIN + 3520
+	           + push_close(strongKing, weakKing)
+	           + 420 * push_to_corner(weakKing));
+}
+
+// Rook against bishop is a draw in general, but the defender has to stay
+// away from the edge
+Value evaluate_KRKB(const Position& pos, Color strongSide) {
+	return Value(push_to_edge(king_square(pos, flip_color(strongSide))));
+}
+
+// Rook against knight: also keep the knight away from its king
+Value evaluate_KRKN(const Position& pos, Color strongSide) {
+	Color weakSide = flip_color(strongSide);
+	Square weakKing = king_square(pos, weakSide);
+	Square weakKnight = lsb(pos.pieces(weakSide, KNIGHT));
+	return Value(push_to_edge(weakKing) + push_away(weakKing, weakKnight));
+}
+
+// Queen against rook is a win, but a long one
+Value evaluate_KQKR(const Position& pos, Color strongSide) {
+	Square strongKing = king_square(pos, strongSide);
+	Square weakKing = king_square(pos, flip_color(strongSide));
+	return Value(QueenValueEg - RookValueEg
+	           + push_to_edge(weakKing)
+	           + push_close(strongKing, weakKing));
+}
+
+// Two knights cannot force mate
+Value evaluate_KNNK(const Position&, Color) {
+	return VALUE_DRAW;
+}
+
+// Material key of a code like "KBNK", strong side pieces first, with
+// the strong side playing color c
+Key material_key(const std::string& code, Color c) {
+	assert(code.length() > 0 && code.length() < 8 && code[0] == 'K');
+
+	std::string sides[] = { code.substr(code.find('K', 1)),      // Weak
+	                        code.substr(0, code.find('K', 1)) }; // Strong
+	std::transform(sides[c].begin(), sides[c].end(), sides[c].begin(), ::tolower);
+
+	std::string fen = "8/" + sides[0] + char(8 - sides[0].length() + '0') + "/8/8/8/8/"
+	                + sides[1] + char(8 - sides[1].length() + '0') + "/8 w - - 0 10";
+
+	StateInfo st;
+	Position pos;
+	pos.set(fen, st);
+	return pos.material_key();
+}
+
+void add(const std::string& code, Endgames::EndgameFn fn) {
+	Registry[material_key(code, WHITE)] = { fn, WHITE };
+	Registry[material_key(code, BLACK)] = { fn, BLACK };
+}
+
+// The strong side has mating material and the weak side a bare king
+bool is_KXK(const Position& pos, Color us) {
+	return !more_than_one(pos.pieces(flip_color(us)))
+	    && pos.non_pawn_material(us) >= RookValueMg;
+}
+
+} // namespace
+
+namespace Endgames {
+
+void init() {
+	Registry.clear();
+	EndgameKXK[WHITE] = { evaluate_KXK, WHITE };
+	EndgameKXK[BLACK] = { evaluate_KXK, BLACK };
+
+	add("KBNK", evaluate_KBNK);
+	add("KRKB", evaluate_KRKB);
+	add("KRKN", evaluate_KRKN);
+	add("KQKR", evaluate_KQKR);
+	add("KNNK", evaluate_KNNK);
+}
+
+const Endgame* probe(const Position& pos) {
+	auto it = Registry.find(pos.material_key());
+	if (it != Registry.end()) return &it->second;
+
+	for (Color c : { WHITE, BLACK }) {
+		if (is_KXK(pos, c)) return &EndgameKXK[c];
+	}
+	return nullptr;
+}
+
+} // namespace Endgames
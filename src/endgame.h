@@ -0,0 +1,27 @@
+#ifndef ENDGAME_H_INCLUDED
+#define ENDGAME_H_INCLUDED
+
+#include "position.h"
+#include "types.h"
+
+namespace Endgames {
+
+// Evaluation of a position of known material, from the point of view of
+// the strong side
+typedef Value (*EndgameFn)(const Position& pos, Color strongSide);
+
+struct Endgame {
+	EndgameFn fn;
+	Color strongSide;
+};
+
+// Build the registry of specialized endgames, keyed on material key. Must
+// be called after Position::init(), which sets up the Zobrist keys.
+void init();
+
+// Specialized evaluation function for the material of pos, or nullptr
+const Endgame* probe(const Position& pos);
+
+} // namespace Endgames
+
+#endif
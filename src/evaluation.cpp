@@ -1,409 +1,658 @@
-#include "evaluation.h"
-#include "bitboard.h"
-#include "position.h"
-#include "types.h"
-#include <algorithm>
-
-// --- Constants & Weights ---
-
-// Helper to create Score (MG, EG)
-constexpr Score S(int mg, int eg) {
-	return make_score(mg, eg);
-}
-
-// Material adjustments (Bishop Pair)
-constexpr Score BonusBishopPair = S(30, 50);
-
-// Pawn Structure Weights
-constexpr Score ScoreIsolated    = S(-10, -10);
-constexpr Score ScoreDoubled     = S(-10, -20);
-constexpr Score ScoreBackward    = S(-15, -10);
-constexpr Score ScorePawnShield  = S(10, 0); // Bonus for having a pawn shield
-constexpr Score ScoreNoPawnShield = S(-20, -5); // Penalty for missing shield
-
-// Passed Pawn Bonus by Rank (0-7)
-constexpr Score BonusPassedPawn[RANK_NB] = {
-	S(0, 0), S(5, 10), S(10, 20), S(20, 40), S(40, 70), S(80, 120), S(150, 200), S(0, 0)
-};
-
-// Piece Activity
-constexpr Score BonusRookOpenFile     = S(30, 15);
-constexpr Score BonusRookSemiOpenFile = S(15, 10);
-constexpr Score BonusKnightOutpost    = S(30, 10);
-constexpr Score BonusBishopOutpost    = S(20, 10);
-constexpr Score BonusRookOn7th        = S(20, 40);
-constexpr Score BonusKingSafety       = S(20, 5);
-
-// Mobility Weights (Simple count of available squares)
-constexpr Score MobilityKnight = S(4, 4);
-constexpr Score MobilityBishop = S(4, 4);
-constexpr Score MobilityRook   = S(3, 4);
-constexpr Score MobilityQueen  = S(2, 4);
-
-// King Safety
-constexpr Score KingAttackWeight = S(2, 0); // Per attacker/attacked square
-
-// Penalty
-constexpr Score PenaltyKnightOnRim = S(20, 5);
-constexpr Score PenaltyEarlyQueen = S(15, 0);
-
-// --- Helper Functions ---
-
-// Bitboard helpers that might be missing in bitboard.h but are needed here
-namespace {
-	inline Bitboard file_bb(File f) { return FileMask[f]; }
-	inline Bitboard rank_bb(Rank r) { return RankMask[r]; }
-
-	inline Bitboard adjacent_files_bb(File f) {
-		Bitboard b = 0;
-		if (f > FILE_A) b |= FileMask[f - 1];
-		if (f < FILE_H) b |= FileMask[f + 1];
-		return b;
-	}
-
-	inline Bitboard forward_ranks_bb(Color c, Rank r) {
-		Bitboard b = 0;
-		if (c == WHITE) {
-			for (int i = r + 1; i < RANK_NB; ++i) b |= RankMask[i];
-		} else {
-			for (int i = r - 1; i >= RANK_1; --i) b |= RankMask[i];
-		}
-		return b;
-	}
-
-	inline Bitboard in_front_bb(Color c, Square s) {
-		return forward_ranks_bb(c, get_rank(s)) & file_bb(get_file(s));
-	}
-	
-	// Simple sliding attack generation for evaluation (since Magic Bitboards aren't in the project)
-	Bitboard get_sliding_attacks(PieceType pt, Square sq, Bitboard occ) {
-		Bitboard attacks = 0;
-		const int (*dirs)[2];
-		int num_dirs = 0;
-
-		static const int r_dirs[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
-		static const int b_dirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-		
-		if (pt == ROOK) { dirs = r_dirs; num_dirs = 4; }
-		else if (pt == BISHOP) { dirs = b_dirs; num_dirs = 4; }
-		else { // Queen
-			 // Combine both, but for simplicity in this helper, handle separately or merge
-			 return get_sliding_attacks(ROOK, sq, occ) | get_sliding_attacks(BISHOP, sq, occ);
-		}
-
-		for(int i=0; i<num_dirs; ++i) {
-			Square t = sq;
-			while(true) {
-				t = advance(t, dirs[i][0], dirs[i][1]);
-				if (!is_ok(t)) break;
-				act_bit(attacks, t);
-				if (hav_bit(occ, t)) break;
-			}
-		}
-		return attacks;
-	}
-}
-
-// --- Evaluation Class ---
-
-struct EvalInfo {
-	const Position& pos;
-	Bitboard pawns[COLOR_NB];
-	Bitboard pieces[COLOR_NB];
-	Bitboard mobilityArea[COLOR_NB];
-	Bitboard kingRing[COLOR_NB];
-	Bitboard attackedBy[COLOR_NB][PIECE_TYPE_NB]; // [Color][AttackerType]
-	Bitboard allAttackedBy[COLOR_NB];
-	
-	Score score;
-
-	EvalInfo(const Position& p) : pos(p), score(SCORE_ZERO) {
-		pawns[WHITE] = pos.pieces(WHITE, PAWN);
-		pawns[BLACK] = pos.pieces(BLACK, PAWN);
-		pieces[WHITE] = pos.pieces(WHITE);
-		pieces[BLACK] = pos.pieces(BLACK);
-		
-		// Initialize mobility area: squares not attacked by enemy pawns
-		// and not occupied by our own pawns (blocked)
-		mobilityArea[WHITE] = ~(pieces[WHITE] & pawns[WHITE]); // Exclude own pawns
-		mobilityArea[BLACK] = ~(pieces[BLACK] & pawns[BLACK]);
-		
-		// Calculate Pawn Attacks first as they define safe mobility area
-		allAttackedBy[WHITE] = 0;
-		allAttackedBy[BLACK] = 0;
-		
-		// We need to fill attackedBy for pawns to exclude from mobility
-		// Note: This is expensive to do fully, we approximate.
-	}
-};
-
-// --- Evaluation Terms ---
-
-void eval_pawns(EvalInfo& ei, Color us) {
-	Color them = flip_color(us);
-	Bitboard ourPawns = ei.pawns[us];
-	Bitboard theirPawns = ei.pawns[them];
-	Direction up = push_pawn(us);
-
-	Bitboard b = ourPawns;
-	while (b) {
-		Square s = pop_lsb(b);
-		File f = get_file(s);
-		Rank r = get_rank(s);
-
-		// 1. Isolated Pawn
-		// No pawns on adjacent files
-		if ((ei.pawns[us] & adjacent_files_bb(f)) == 0) {
-			ei.score += (us == WHITE ? ScoreIsolated : -ScoreIsolated);
-		}
-
-		// 2. Doubled Pawn
-		// Another pawn of ours on the same file
-		if ((ei.pawns[us] & file_bb(f) & ~square_bb(s))) {
-			 // We only penalize the rear pawn usually, or just count all. 
-			 // Simple approach: penalize every doubled pawn.
-			 ei.score += (us == WHITE ? ScoreDoubled : -ScoreDoubled);
-		}
-
-		// 3. Passed Pawn
-		// No enemy pawns in front on the same file or adjacent files
-		Bitboard frontSpan = forward_ranks_bb(us, r);
-		Bitboard span = frontSpan & (file_bb(f) | adjacent_files_bb(f));
-		
-		if ((span & theirPawns) == 0) {
-			Score bonus = BonusPassedPawn[r];
-			
-			// Bonus increases if the passed pawn is supported or blockaded?
-			// For now, simple rank-based bonus.
-			ei.score += (us == WHITE ? bonus : -bonus);
-		}
-		
-		// 4. Backward Pawn (Simplified)
-		// Cannot advance safely and no support from behind
-		// (Omitted for brevity/complexity, relying on Isolated/Doubled for structure)
-	}
-}
-
-void eval_pieces(EvalInfo& ei, Color us) {
-	Color them = flip_color(us);
-	Bitboard occupied = ei.pos.pieces();
-	Bitboard ourPawns = ei.pawns[us];
-	Bitboard theirPawns = ei.pawns[them];
-	
-	// Outpost ranks: 4, 5, 6 (relative)
-	Rank r4 = (us == WHITE ? RANK_4 : RANK_5);
-	Rank r5 = (us == WHITE ? RANK_5 : RANK_4);
-	Rank r6 = (us == WHITE ? RANK_6 : RANK_3);
-	Bitboard outpostRanks = rank_bb(r4) | rank_bb(r5) | rank_bb(r6);
-
-	// --- Knights ---
-	Bitboard knights = ei.pos.pieces(us, KNIGHT);
-	while (knights) {
-		Square s = pop_lsb(knights);
-		
-		// Mobility
-		Bitboard attacks = PseudoAttacks[KNIGHT][s];
-		int mob = __builtin_popcountll(attacks & ei.mobilityArea[us]);
-		ei.score += (us == WHITE ? MobilityKnight * mob : -MobilityKnight * mob);
-
-		// penalize knights on rim
-		File f = get_file(s);
-		if (f == FILE_A || f == FILE_H) {
-			ei.score -= (us == WHITE ? PenaltyKnightOnRim : -PenaltyKnightOnRim);
-		}
-
-		// Outpost
-		if (hav_bit(outpostRanks, s)) {
-			// Supported by pawn
-			if (PawnAttacks[them][s] & ourPawns) { // PawnAttacks[them][s] gives squares that attack s from 'them' perspective? 
-				// No, PawnAttacks[c][s] usually means squares attacked BY pawns of color c located at s.
-				// We need to check if 's' is attacked by 'our' pawns.
-				// That is equivalent to: is there a pawn of 'us' that attacks 's'?
-				// Which is: PawnAttacks[them][s] & ourPawns. (Geometry is symmetric).
-				ei.score += (us == WHITE ? BonusKnightOutpost : -BonusKnightOutpost);
-			}
-		}
-	}
-
-	// --- Bishops ---
-	Bitboard bishops = ei.pos.pieces(us, BISHOP);
-	if (__builtin_popcountll(bishops) >= 2) {
-		ei.score += (us == WHITE ? BonusBishopPair : -BonusBishopPair);
-	}
-
-	while (bishops) {
-		Square s = pop_lsb(bishops);
-		
-		// Mobility (Pseudo)
-		Bitboard attacks = get_sliding_attacks(BISHOP, s, occupied);
-		int mob = __builtin_popcountll(attacks & ei.mobilityArea[us]);
-		ei.score += (us == WHITE ? MobilityBishop * mob : -MobilityBishop * mob);
-	}
-
-	// --- Rooks ---
-	Bitboard rooks = ei.pos.pieces(us, ROOK);
-	while (rooks) {
-		Square s = pop_lsb(rooks);
-		File f = get_file(s);
-		Rank r = get_rank(s);
-
-		// Open / Semi-Open Files
-		bool ourPawn = (file_bb(f) & ourPawns);
-		bool theirPawn = (file_bb(f) & theirPawns);
-
-		if (!ourPawn) {
-			if (!theirPawn) {
-				ei.score += (us == WHITE ? BonusRookOpenFile : -BonusRookOpenFile);
-			} else {
-				ei.score += (us == WHITE ? BonusRookSemiOpenFile : -BonusRookSemiOpenFile);
-			}
-		}
-
-		// Rook on 7th Rank (relative)
-		Rank r7 = (us == WHITE ? RANK_7 : RANK_2);
-		if (r == r7) {
-			// Bonus if enemy king is on rank 8 or cut off
-			ei.score += (us == WHITE ? BonusRookOn7th : -BonusRookOn7th);
-		}
-
-		// Mobility
-		Bitboard attacks = get_sliding_attacks(ROOK, s, occupied);
-		int mob = __builtin_popcountll(attacks & ei.mobilityArea[us]);
-		ei.score += (us == WHITE ? MobilityRook * mob : -MobilityRook * mob);
-	}
-	
-	// --- Queens ---
-	Bitboard queens = ei.pos.pieces(us, QUEEN);
-
-	// early queen penalty
-	Bitboard backRank = (us == WHITE ? RankMask[RANK_1] : RankMask[RANK_8]);
-	Bitboard minorsOnBackRank = ei.pos.pieces(us, KNIGHT) | ei.pos.pieces(us, BISHOP);
-	minorsOnBackRank &= backRank;
-	int undevelopedMinors = __builtin_popcountll(minorsOnBackRank);
-
-	while (queens) {
-		Square s = pop_lsb(queens);
-		Bitboard attacks = get_sliding_attacks(QUEEN, s, occupied);
-		int mob = __builtin_popcountll(attacks & ei.mobilityArea[us]);
-		ei.score += (us == WHITE ? MobilityQueen * mob : -MobilityQueen * mob);
-
-		// Apply Penalty if Queen has moved but minors are sleeping
-		// We assume if the queen is NOT on her starting square (D1/D8), she moved.
-		Square startSq = (us == WHITE ? SQ_D1 : SQ_D8);
-		if (s != startSq && undevelopedMinors > 1) {
-			 ei.score -= (us == WHITE ? PenaltyEarlyQueen * undevelopedMinors : -PenaltyEarlyQueen * undevelopedMinors);
-		}
-	}
-}
-
-void eval_king_safety(EvalInfo& ei, Color us) {
-	Color them = flip_color(us);
-	Square ksq = lsb(ei.pos.pieces(us, KING));
-
-	// If King is on files G or B (Kingside) or C (Queenside)
-	// AND it is on the back rank, give a bonus.
-	const File f = get_file(ksq);
-	const Rank r = get_rank(ksq);
-	Rank backRank = (us == WHITE ? RANK_1 : RANK_8);
-
-	if (r == backRank) {
-		// G-file (Kingside), B/C-file (Queenside)
-		if (f == FILE_G || f == FILE_B || f == FILE_C) {
-			ei.score += (us == WHITE ? BonusKingSafety : -BonusKingSafety);
-		}
-	}
-	
-	// 1. Pawn Shield (Mainly MG)
-	// Check pawns in front of the king
-	Bitboard shieldMask = 0;
-	
-	// Define shield squares based on King rank (usually 1 or 2 for white)
-	if (us == WHITE ? r <= RANK_2 : r >= RANK_7) {
-		// Check 3 files around king, rank + 1
-		Rank r_shield = Rank(us == WHITE ? r + 1 : r - 1);
-		if (r_shield >= RANK_1 && r_shield <= RANK_8) {
-			if (f > FILE_A) act_bit(shieldMask, make_square(File(f-1), r_shield));
-			act_bit(shieldMask, make_square(f, r_shield));
-			if (f < FILE_H) act_bit(shieldMask, make_square(File(f+1), r_shield));
-		}
-		
-		// Count pawns in shield
-		int shieldCount = __builtin_popcountll(shieldMask & ei.pawns[us]);
-		if (shieldCount == 3) ei.score += (us == WHITE ? ScorePawnShield : -ScorePawnShield);
-		else if (shieldCount < 2) ei.score += (us == WHITE ? ScoreNoPawnShield : -ScoreNoPawnShield);
-	}
-
-	// 2. King Safety / Attacked Squares (Simplified)
-	// Identify a "King Ring" around the king
-	Bitboard kingRing = PseudoAttacks[KING][ksq];
-	
-	// Check for enemy pieces attacking the ring
-	// Note: This requires generating attacks for all enemy pieces, which is expensive.
-	// We rely on a simplified check or skip if performance is key.
-	// For this implementation, we will skip full attack generation to keep it fast,
-	// relying on the Pawn Shield and general activity.
-}
-
-// --- Main Evaluation Function ---
-
-Value eval(const Position &pos) {
-	EvalInfo ei(pos);
-
-	// 1. Material & PSQT (Base)
-	// This is usually incrementally updated, but here we calculate from scratch
-	// or rely on what's available. The provided code in evaluation.cpp
-	// calculated this manually. We will do the same but accumulate into Score.
-	
-	for (PieceType pt = PAWN; pt <= KING; ++pt) {
-		Bitboard w = pos.pieces(WHITE, pt);
-		Bitboard b = pos.pieces(BLACK, pt);
-		
-		while (w) {
-			Square s = pop_lsb(w);
-			ei.score += PSQT::psq[make_piece(WHITE, pt)][s];
-		}
-		while (b) {
-			Square s = pop_lsb(b);
-			ei.score -= PSQT::psq[make_piece(BLACK, pt)][s];
-		}
-	}
-
-	// 2. Pawn Structure
-	eval_pawns(ei, WHITE);
-	eval_pawns(ei, BLACK);
-
-	// 3. Piece Activity & Structure
-	eval_pieces(ei, WHITE);
-	eval_pieces(ei, BLACK);
-
-	// 4. King Safety
-	eval_king_safety(ei, WHITE);
-	eval_king_safety(ei, BLACK);
-
-	// 5. Tapered Evaluation (Phase Calculation)
-	// Calculate Phase
-	int npm = 0; // Non-pawn material
-	npm += __builtin_popcountll(pos.pieces(KNIGHT)) * KnightValueMg;
-	npm += __builtin_popcountll(pos.pieces(BISHOP)) * BishopValueMg;
-	npm += __builtin_popcountll(pos.pieces(ROOK))   * RookValueMg;
-	npm += __builtin_popcountll(pos.pieces(QUEEN))  * QueenValueMg;
-
-	int phase = std::min(npm, (int)MidgameLimit); 
-	phase = std::max(phase, (int)EndgameLimit);
-	
-	// Phase factor: 0 (Endgame) to 128 (Midgame)
-	int p = ((phase - EndgameLimit) * 128) / (MidgameLimit - EndgameLimit);
-
-	// Interpolate
-	Value mg = mg_value(ei.score);
-	Value eg = eg_value(ei.score);
-	
-	Value v = Value((mg * p + eg * (128 - p)) / 128);
-
-	// 6. Tempo
-	const Value TEMPO = Value(20);
-	if (pos.side_to_move() == WHITE) v += TEMPO;
-	else v -= TEMPO;
-
-	return (pos.side_to_move() == WHITE) ? v : -v;
-}
+#include "evaluation.h"
+#include "bitboard.h"
+#include "material.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "option.h"
+#include "position.h"
+#include "thread.h"
+#include "types.h"
+#include "tune.h"
+#include "weights.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// --- Constants & Weights ---
+// The weights of the linear terms are in weights.h
+
+// King Safety: attack units of a piece attacking the king ring, and of a
+// safe check by a piece type
+constexpr int KingAttackWeights[PIECE_TYPE_NB] = { 0, 0, 81, 52, 44, 10 };
+constexpr int SafeCheckWeights[PIECE_TYPE_NB] = { 0, 0, 792, 645, 1084, 772 };
+
+// --- Evaluation Class ---
+
+struct EvalInfo {
+	const Position& pos;
+	Bitboard pawns[COLOR_NB];
+	Bitboard pieces[COLOR_NB];
+	Bitboard mobilityArea[COLOR_NB];
+	Bitboard kingRing[COLOR_NB];
+	Bitboard attackedBy[COLOR_NB][PIECE_TYPE_NB]; // [Color][AttackerType]
+	Bitboard allAttackedBy[COLOR_NB];
+
+	// Pieces of a color attacking the enemy king ring, the sum of their
+	// KingAttackWeights, and their attacks on squares next to the king
+	int kingAttackersCount[COLOR_NB];
+	int kingAttackersWeight[COLOR_NB];
+	int kingAttacksCount[COLOR_NB];
+
+	Material::Entry* me;
+	Pawns::Entry* pe;
+	
+	Score score;
+
+	EvalInfo(const Position& p) : pos(p), me(nullptr), pe(nullptr), score(SCORE_ZERO) {
+		pawns[WHITE] = pos.pieces(WHITE, PAWN);
+		pawns[BLACK] = pos.pieces(BLACK, PAWN);
+		pieces[WHITE] = pos.pieces(WHITE);
+		pieces[BLACK] = pos.pieces(BLACK);
+	}
+};
+
+// --- Attack Maps ---
+
+// Start the attack maps of a color with its pawns and king, before the
+// pieces of both colors are evaluated. Needs the pawn entry.
+template<Color Us>
+void init_attacks(EvalInfo& ei) {
+	constexpr Color Them = ~Us;
+	Square ksq = lsb(ei.pos.pieces(Us, KING));
+
+	for (PieceType pt = PAWN; pt <= KING; ++pt) ei.attackedBy[Us][pt] = 0;
+	ei.attackedBy[Us][PAWN] = ei.pe->pawn_attacks(Us);
+	ei.attackedBy[Us][KING] = PseudoAttacks[KING][ksq];
+	ei.allAttackedBy[Us] = ei.attackedBy[Us][PAWN] | ei.attackedBy[Us][KING];
+	ei.kingRing[Us] = ei.attackedBy[Us][KING] | square_bb(ksq);
+
+	// Our pieces are mobile on squares not occupied by our pawns or king,
+	// and not attacked by their pawns
+	ei.mobilityArea[Us] = ~(ei.pawns[Us] | ei.pos.pieces(Us, KING) | ei.pe->pawn_attacks(Them));
+
+	ei.kingAttackersCount[Them] = __builtin_popcountll(ei.kingRing[Us] & ei.pe->pawn_attacks(Them));
+	ei.kingAttackersWeight[Them] = 0;
+	ei.kingAttacksCount[Them] = 0;
+}
+
+// Attacks of the piece of type Pt on s, added to the attack maps and to
+// the attacks on the enemy king
+template<Color Us, PieceType Pt>
+Bitboard piece_attacks(EvalInfo& ei, Square s) {
+	constexpr Color Them = ~Us;
+	Bitboard attacks = attacks_bb(Pt, s, ei.pos.pieces());
+
+	ei.attackedBy[Us][Pt] |= attacks;
+	ei.allAttackedBy[Us] |= attacks;
+
+	if (attacks & ei.kingRing[Them]) {
+		++ei.kingAttackersCount[Us];
+		ei.kingAttackersWeight[Us] += KingAttackWeights[Pt];
+		ei.kingAttacksCount[Us] += __builtin_popcountll(attacks & ei.attackedBy[Them][KING]);
+	}
+	return attacks;
+}
+
+// --- Evaluation Terms ---
+// Each term is scored from the point of view of Us, the caller combines
+// them as white - black.
+
+template<Tracing T, Color Us, PieceType Pt>
+Score eval_pieces(EvalInfo& ei) {
+	constexpr Color Them = ~Us;
+	constexpr Bitboard OutpostRanks = Us == WHITE ? RankMask[RANK_4] | RankMask[RANK_5] | RankMask[RANK_6]
+	                                              : RankMask[RANK_5] | RankMask[RANK_4] | RankMask[RANK_3];
+	constexpr Bitboard BackRank = Us == WHITE ? RankMask[RANK_1] : RankMask[RANK_8];
+	constexpr Rank Rank7 = relative_rank(Us, RANK_7);
+	constexpr Square QueenStart = relative_square(Us, SQ_D1);
+	constexpr Score Mobility = Pt == KNIGHT ? MobilityKnight
+	                         : Pt == BISHOP ? MobilityBishop
+	                         : Pt == ROOK   ? MobilityRook : MobilityQueen;
+	constexpr Tune::Param MobilityParam = Tune::Param(Tune::KNIGHT_MOBILITY + Pt - KNIGHT);
+
+	Score score = SCORE_ZERO;
+	Bitboard pieces = ei.pos.pieces(Us, Pt);
+	while (pieces) {
+		Square s = pop_lsb(pieces);
+
+		// Mobility
+		Bitboard attacks = piece_attacks<Us, Pt>(ei, s);
+		int mob = __builtin_popcountll(attacks & ei.mobilityArea[Us]);
+		score += Mobility * mob;
+		if constexpr (T == TRACE) Tune::add(MobilityParam, Us, mob);
+
+		if constexpr (Pt == KNIGHT) {
+			// penalize knights on rim
+			File f = get_file(s);
+			if (f == FILE_A || f == FILE_H) {
+				score -= PenaltyKnightOnRim;
+				if constexpr (T == TRACE) Tune::add(Tune::KNIGHT_ON_RIM, Us, -1);
+			}
+
+			// Outpost, supported by one of our pawns
+			if ((OutpostRanks & square_bb(s)) && (ei.attackedBy[Us][PAWN] & square_bb(s))) {
+				score += BonusKnightOutpost;
+				if constexpr (T == TRACE) Tune::add(Tune::KNIGHT_OUTPOST, Us);
+			}
+		}
+
+		if constexpr (Pt == ROOK) {
+			Bitboard file = file_bb(get_file(s));
+
+			// Open / Semi-Open Files
+			if (!(file & ei.pawns[Us])) {
+				bool semiOpen = file & ei.pawns[Them];
+				score += semiOpen ? BonusRookSemiOpenFile : BonusRookOpenFile;
+				if constexpr (T == TRACE) Tune::add(semiOpen ? Tune::ROOK_SEMI_OPEN_FILE : Tune::ROOK_OPEN_FILE, Us);
+			}
+
+			// Rook on 7th Rank (relative)
+			if (get_rank(s) == Rank7) {
+				score += BonusRookOn7th;
+				if constexpr (T == TRACE) Tune::add(Tune::ROOK_ON_7TH, Us);
+			}
+		}
+
+		if constexpr (Pt == QUEEN) {
+			// early queen penalty: the queen has left her starting square
+			// (D1/D8) while the minors are sleeping on the back rank
+			int undevelopedMinors = __builtin_popcountll((ei.pos.pieces(Us, KNIGHT) | ei.pos.pieces(Us, BISHOP)) & BackRank);
+			if (s != QueenStart && undevelopedMinors > 1) {
+				score -= PenaltyEarlyQueen * undevelopedMinors;
+				if constexpr (T == TRACE) Tune::add(Tune::EARLY_QUEEN, Us, -undevelopedMinors);
+			}
+		}
+	}
+
+	return score;
+}
+
+template<Color Us>
+Score eval_king_safety(EvalInfo& ei) {
+	constexpr Color Them = ~Us;
+	const Position& pos = ei.pos;
+	Square ksq = lsb(pos.pieces(Us, KING));
+
+	// 1. King placement and pawn shield, cached in the pawn hash entry
+	Score score = ei.pe->king_safety<Us>(pos);
+
+	// 2. Attacks on the king, in attack units. Only with at least two
+	// attackers, or one and a queen.
+	if (ei.kingAttackersCount[Them] > 1 - pos.count(make_piece(Them, QUEEN))) {
+		// Squares next to the king attacked by them and defended at most by
+		// our king or queen
+		Bitboard weak = ei.allAttackedBy[Them] & ~ei.attackedBy[Us][PAWN]
+		              & ~(ei.attackedBy[Us][KNIGHT] | ei.attackedBy[Us][BISHOP] | ei.attackedBy[Us][ROOK])
+		              & ei.attackedBy[Us][KING];
+
+		// Checks from squares not defended by us
+		Bitboard safe = ~pos.pieces(Them) & ~ei.allAttackedBy[Us];
+		Bitboard rookLines = attacks_bb(ROOK, ksq, pos.pieces());
+		Bitboard bishopLines = attacks_bb(BISHOP, ksq, pos.pieces());
+		int kingDanger = 0;
+		if (rookLines & safe & ei.attackedBy[Them][ROOK]) kingDanger += SafeCheckWeights[ROOK];
+		if ((rookLines | bishopLines) & safe & ei.attackedBy[Them][QUEEN]) kingDanger += SafeCheckWeights[QUEEN];
+		if (bishopLines & safe & ei.attackedBy[Them][BISHOP]) kingDanger += SafeCheckWeights[BISHOP];
+		if (PseudoAttacks[KNIGHT][ksq] & safe & ei.attackedBy[Them][KNIGHT]) kingDanger += SafeCheckWeights[KNIGHT];
+
+		kingDanger += ei.kingAttackersCount[Them] * ei.kingAttackersWeight[Them]
+		            + 185 * __builtin_popcountll(ei.kingRing[Us] & weak)
+		            + 69 * ei.kingAttacksCount[Them]
+		            - 873 * !pos.count(make_piece(Them, QUEEN))
+		            - 30;
+
+		// Quadratic in the middlegame, the king is less exposed in the endgame
+		if (kingDanger > 100) {
+			score -= make_score(kingDanger * kingDanger / 4096, kingDanger / 16);
+		}
+	}
+
+	return score;
+}
+
+// Scale factor of the endgame score for the side it favours
+int scale_factor(const EvalInfo& ei, Value eg) {
+	const Position& pos = ei.pos;
+	Color strongSide = eg > VALUE_DRAW ? WHITE : BLACK;
+	int sf = ei.me->scale_factor(strongSide);
+
+	// Opposite colored bishops are drawish, even more so without other pieces
+	if (sf == SCALE_FACTOR_NORMAL
+	    && pos.count(W_BISHOP) == 1 && pos.count(B_BISHOP) == 1
+	    && opposite_colors(lsb(pos.pieces(WHITE, BISHOP)), lsb(pos.pieces(BLACK, BISHOP)))) {
+		if (pos.non_pawn_material(WHITE) == BishopValueMg
+		    && pos.non_pawn_material(BLACK) == BishopValueMg) {
+			sf = more_than_one(pos.pieces(PAWN)) ? 31 : 9;
+		}
+		else {
+			sf = 46;
+		}
+	}
+	return sf;
+}
+
+// --- Debug Helpers ---
+
+// Full recomputation of the incrementally updated terms, for debug checks
+[[maybe_unused]] static Score compute_psq_score(const Position& pos) {
+	Score score = SCORE_ZERO;
+	for (PieceType pt = PAWN; pt <= KING; ++pt) {
+		Bitboard w = pos.pieces(WHITE, pt);
+		Bitboard b = pos.pieces(BLACK, pt);
+		while (w) score += PSQT::psq[make_piece(WHITE, pt)][pop_lsb(w)];
+		while (b) score -= PSQT::psq[make_piece(BLACK, pt)][pop_lsb(b)];
+	}
+	return score;
+}
+
+[[maybe_unused]] static Value compute_non_pawn_material(const Position& pos) {
+	return Value(__builtin_popcountll(pos.pieces(KNIGHT)) * KnightValueMg
+	           + __builtin_popcountll(pos.pieces(BISHOP)) * BishopValueMg
+	           + __builtin_popcountll(pos.pieces(ROOK))   * RookValueMg
+	           + __builtin_popcountll(pos.pieces(QUEEN))  * QueenValueMg);
+}
+
+// --- Main Evaluation Function ---
+
+// Positions whose material and piece-square score is this far outside the
+// window are not evaluated further, from the "Lazy Margin" option
+int LazyMargin = 400;
+
+void Eval::init() {
+	LazyMargin = get_option_int("Lazy Margin");
+}
+
+void Eval::on_param_change(const Option&) {
+	Eval::init();
+}
+
+// --- Trace ---
+// The terms of one evaluation for the "eval" command, and the time spent
+// in each term for "evalbench". The hooks are compiled out of the
+// evaluation used by the search.
+
+namespace Trace {
+
+// Pawns, pieces and king safety are indexed by their piece type
+enum Term { MATERIAL = 8, IMBALANCE, ATTACKS, SCALING, TOTAL, TEMPO, TERM_NB };
+
+Score scores[TERM_NB][COLOR_NB];
+int phase, scaleFactor;
+int64_t nanos[TERM_NB];
+std::chrono::steady_clock::time_point last;
+
+void add(int term, Color c, Score s) {
+	scores[term][c] = s;
+}
+
+void add(int term, Score w, Score b = SCORE_ZERO) {
+	scores[term][WHITE] = w;
+	scores[term][BLACK] = b;
+}
+
+// Charge the time since the last lap to term
+void lap(int term) {
+	auto t = std::chrono::steady_clock::now();
+	nanos[term] += std::chrono::duration_cast<std::chrono::nanoseconds>(t - last).count();
+	last = t;
+}
+
+std::ostream& operator<<(std::ostream& os, Score s) {
+	return os << std::setw(6) << int(mg_value(s)) << std::setw(6) << int(eg_value(s));
+}
+
+// A row of the trace table. Material imbalance and the total only exist as
+// a difference.
+std::ostream& operator<<(std::ostream& os, Term t) {
+	if (t == IMBALANCE || t == TOTAL) {
+		os << " |   ----  ---- |   ----  ---- |";
+	} else {
+		os << " | " << scores[t][WHITE] << " | " << scores[t][BLACK] << " |";
+	}
+	return os << " " << scores[t][WHITE] - scores[t][BLACK] << std::endl;
+}
+
+} // namespace Trace
+
+using namespace Trace;
+
+// Scores of both colors for one piece type
+template<Tracing T, PieceType Pt>
+Score pieces_score(EvalInfo& ei) {
+	Score w = eval_pieces<T, WHITE, Pt>(ei);
+	Score b = eval_pieces<T, BLACK, Pt>(ei);
+	if constexpr (T == TRACE) Trace::add(Pt, w, b);
+	if constexpr (T == PROFILE) Trace::lap(Pt);
+	return w - b;
+}
+
+// Evaluation from the point of view of the side to move. The positional
+// terms are skipped, and lazy is set, when the material and piece-square
+// score alone is beyond the window [alpha, beta] by the lazy margin.
+template<Tracing T>
+static Value evaluate(const Position &pos, Value alpha, Value beta, bool& lazy) {
+	EvalInfo ei(pos);
+
+	if constexpr (T == PROFILE) Trace::last = std::chrono::steady_clock::now();
+	if constexpr (T == TRACE) std::memset(Tune::Coefficients, 0, sizeof(Tune::Coefficients));
+
+	// 1. Material & PSQT (Base), updated incrementally by the position
+	assert(pos.psq_score() == compute_psq_score(pos));
+	assert(pos.non_pawn_material() == compute_non_pawn_material(pos));
+	ei.score += pos.psq_score();
+	if constexpr (T == TRACE) {
+		for (Color c : { WHITE, BLACK }) {
+			Score psq = SCORE_ZERO;
+			for (Bitboard b = pos.pieces(c); b; ) {
+				Square s = pop_lsb(b);
+				psq += PSQT::psq[pos.piece_on(s)][s];
+				Tune::add(Tune::psq_param(get_piece_type(pos.piece_on(s)), c == WHITE ? s : ~s), c);
+			}
+			Trace::add(MATERIAL, c, psq);
+		}
+	}
+
+	// Material imbalance and known endgames, from the material hash table
+	ei.me = Material::probe(pos);
+	if (ei.me->specialized_eval_exists()) {
+		if constexpr (T == PROFILE) Trace::lap(MATERIAL);
+		Value v = ei.me->evaluate(pos);
+		return (pos.side_to_move() == WHITE) ? v : -v;
+	}
+	ei.score += ei.me->imbalance();
+	if constexpr (T == TRACE) {
+		Trace::add(IMBALANCE, ei.me->imbalance());
+		for (Color c : { WHITE, BLACK }) {
+			Tune::add(Tune::BISHOP_PAIR, c, pos.count(make_piece(c, BISHOP)) >= 2);
+		}
+	}
+	if constexpr (T == PROFILE) Trace::lap(MATERIAL);
+
+	// Early exit when the position is clearly lost or won for the window
+	int p = ei.me->game_phase();
+	Value mg = mg_value(ei.score);
+	Value eg = eg_value(ei.score);
+	eg = eg * scale_factor(ei, eg) / SCALE_FACTOR_NORMAL;
+	Value v = Value((mg * p + eg * (128 - p)) / 128);
+	v = ((pos.side_to_move() == WHITE) ? v : -v) + Eval::Tempo;
+	if (v + LazyMargin < alpha || v - LazyMargin > beta) {
+		lazy = true;
+		return v;
+	}
+
+	// 2. Pawn Structure, from the pawn hash table
+	ei.pe = Pawns::probe(pos);
+	ei.score += ei.pe->pawn_score(WHITE) - ei.pe->pawn_score(BLACK);
+	if constexpr (T == TRACE) {
+		Trace::add(PAWN, ei.pe->pawn_score(WHITE), ei.pe->pawn_score(BLACK));
+		Pawns::trace(pos);
+	}
+	if constexpr (T == PROFILE) Trace::lap(PAWN);
+
+	// Attack maps of the pawns and kings, completed by the pieces
+	init_attacks<WHITE>(ei);
+	init_attacks<BLACK>(ei);
+	if constexpr (T == PROFILE) Trace::lap(ATTACKS);
+
+	// 3. Piece Activity & Structure
+	ei.score += pieces_score<T, KNIGHT>(ei);
+	ei.score += pieces_score<T, BISHOP>(ei);
+	ei.score += pieces_score<T, ROOK>(ei);
+	ei.score += pieces_score<T, QUEEN>(ei);
+
+	// 4. King Safety
+	Score w = eval_king_safety<WHITE>(ei);
+	Score b = eval_king_safety<BLACK>(ei);
+	ei.score += w - b;
+	if constexpr (T == TRACE) Trace::add(KING, w, b);
+	if constexpr (T == PROFILE) Trace::lap(KING);
+
+	// 5. Tapered Evaluation, with the phase and the scale factor of the
+	// endgame score from the material hash table
+	mg = mg_value(ei.score);
+	eg = eg_value(ei.score);
+	int sf = scale_factor(ei, eg);
+	eg = eg * sf / SCALE_FACTOR_NORMAL;
+
+	v = Value((mg * p + eg * (128 - p)) / 128);
+	if constexpr (T == TRACE) {
+		Trace::add(TOTAL, ei.score);
+		Trace::phase = p;
+		Trace::scaleFactor = sf;
+	}
+	if constexpr (T == PROFILE) Trace::lap(SCALING);
+
+	// 6. Tempo, for the side to move
+	if constexpr (T == TRACE) {
+		Score tempo = make_score(Eval::Tempo, Eval::Tempo);
+		Trace::add(TEMPO, pos.side_to_move() == WHITE ? tempo : SCORE_ZERO,
+		                  pos.side_to_move() == BLACK ? tempo : SCORE_ZERO);
+	}
+	return ((pos.side_to_move() == WHITE) ? v : -v) + Eval::Tempo;
+}
+
+Value eval(const Position &pos, Value alpha, Value beta, bool& lazy) {
+	// Positions come back through transpositions and re-searches, so the
+	// evaluation of each thread is cached by position key
+	Thread* th = pos.this_thread();
+	EvalCache* cache = th ? &th->evalCache : nullptr;
+	Value v;
+	lazy = false;
+	if (cache && cache->probe(pos.key(), v)) return v;
+
+	if (NNUE::enabled()) {
+		v = NNUE::evaluate(pos);
+		if (cache) cache->store(pos.key(), v);
+		return v;
+	}
+
+	v = evaluate<NO_TRACE>(pos, alpha, beta, lazy);
+	if (th) ++th->lazyStats.evals;
+
+	// A lazy value is only good for this window, it is not cached
+	if (!lazy) {
+		if (cache) cache->store(pos.key(), v);
+		return v;
+	}
+
+	if (th) {
+		LazyEvalStats& ls = th->lazyStats;
+		// Compare a sample of the early exits with the full evaluation: the
+		// error, and how often the full value is on the other side of a bound
+		++ls.exits;
+		if (ls.sampling && ls.exits % LazyEvalStats::SampleRate == 0) {
+			bool full_lazy = false;
+			Value full = evaluate<NO_TRACE>(pos, -VALUE_INFINITE, VALUE_INFINITE, full_lazy);
+			++ls.samples;
+			ls.totalError += std::abs(int(full - v));
+			ls.misjudged += (v >= beta) != (full >= beta) || (v <= alpha) != (full <= alpha);
+		}
+	}
+	return v;
+}
+
+void Eval::evaluate_batch(const PackedPosition* positions, size_t n, Value* scores, int threads) {
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		StateInfo st;
+		Position pos;
+		size_t begin;
+		while ((begin = next.fetch_add(BatchBlock)) < n) {
+			size_t end = std::min(n, begin + BatchBlock);
+			for (size_t i = begin; i < end; ++i) {
+				pos.set(positions[i], st);
+				scores[i] = eval(pos);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; ++t) workers.emplace_back(work);
+	work();
+	for (std::thread& th : workers) th.join();
+}
+
+bool Eval::linearize(const Position& pos, Score& score, int& phase, int& scaleFactor) {
+	if (Material::probe(pos)->specialized_eval_exists()) return false;
+
+	bool lazy = false;
+	evaluate<TRACE>(pos, -VALUE_INFINITE, VALUE_INFINITE, lazy);
+	score = Trace::scores[TOTAL][WHITE];
+	phase = Trace::phase;
+	scaleFactor = Trace::scaleFactor;
+	return true;
+}
+
+std::string Eval::trace(const Position& pos) {
+	std::ostringstream ss;
+	if (Material::probe(pos)->specialized_eval_exists()) {
+		ss << "Specialized endgame evaluation" << std::endl;
+	} else {
+		std::memset(Trace::scores, 0, sizeof(Trace::scores));
+		bool lazy = false;
+		evaluate<TRACE>(pos, -VALUE_INFINITE, VALUE_INFINITE, lazy);
+
+		ss << "         Term |     White    |     Black    |     Total" << std::endl
+		   << "              |     MG    EG |     MG    EG |     MG    EG" << std::endl
+		   << " -------------+--------------+--------------+--------------" << std::endl
+		   << "     Material" << MATERIAL
+		   << "    Imbalance" << IMBALANCE
+		   << "        Pawns" << Term(PAWN)
+		   << "      Knights" << Term(KNIGHT)
+		   << "      Bishops" << Term(BISHOP)
+		   << "        Rooks" << Term(ROOK)
+		   << "       Queens" << Term(QUEEN)
+		   << "  King safety" << Term(KING)
+		   << " -------------+--------------+--------------+--------------" << std::endl
+		   << "        Total" << TOTAL
+		   << "        Tempo" << TEMPO
+		   << "Phase: " << Trace::phase << " (128 is the middlegame)"
+		   << ", endgame scale factor: " << Trace::scaleFactor << "/" << int(SCALE_FACTOR_NORMAL) << std::endl;
+	}
+
+	// Classical and NNUE values, from the side to move as in the search,
+	// with the tempo bonus
+	bool lazy = false;
+	ss << "Classical evaluation: " << int(evaluate<NO_TRACE>(pos, -VALUE_INFINITE, VALUE_INFINITE, lazy))
+	   << " (side to move)" << std::endl;
+	if (NNUE::enabled()) {
+		ss << "NNUE evaluation: " << int(NNUE::evaluate(pos)) << " (side to move)" << std::endl;
+	}
+	return ss.str();
+}
+
+std::string Eval::profile(std::istream& epd, int passes) {
+	std::deque<StateInfo> states;
+	std::vector<Position> positions;
+
+	// The first four fields of each line are the position, EPD operations
+	// or FEN move counters are ignored
+	std::string line;
+	while (std::getline(epd, line)) {
+		std::istringstream ls(line);
+		std::string fen, field;
+		for (int i = 0; i < 4 && ls >> field; ++i) fen += field + " ";
+		if (fen.empty()) continue;
+		states.emplace_back();
+		positions.emplace_back();
+		positions.back().set(fen + "0 1", states.back());
+	}
+
+	std::ostringstream ss;
+	if (positions.empty()) {
+		ss << "No positions" << std::endl;
+		return ss.str();
+	}
+
+	using namespace std::chrono;
+	const double calls = double(positions.size()) * passes;
+	volatile int sink = 0;
+	bool lazy = false;
+
+	// Plain evaluation, as called by the search but without the eval cache
+	auto start = steady_clock::now();
+	for (int i = 0; i < passes; ++i) {
+		for (const Position& pos : positions) {
+			sink = sink + evaluate<NO_TRACE>(pos, -VALUE_INFINITE, VALUE_INFINITE, lazy);
+		}
+	}
+	double plain = duration_cast<nanoseconds>(steady_clock::now() - start).count() / calls;
+
+	// The cost of a timer lap, subtracted from each term below
+	constexpr int Laps = 100000;
+	std::memset(Trace::nanos, 0, sizeof(Trace::nanos));
+	Trace::last = steady_clock::now();
+	for (int i = 0; i < Laps; ++i) Trace::lap(TOTAL);
+	double overhead = double(Trace::nanos[TOTAL]) / Laps;
+
+	// The same with a timer lap after each term
+	std::memset(Trace::nanos, 0, sizeof(Trace::nanos));
+	start = steady_clock::now();
+	for (int i = 0; i < passes; ++i) {
+		for (const Position& pos : positions) {
+			sink = sink + evaluate<PROFILE>(pos, -VALUE_INFINITE, VALUE_INFINITE, lazy);
+		}
+	}
+	double profiled = duration_cast<nanoseconds>(steady_clock::now() - start).count() / calls;
+
+	ss << "Positions: " << positions.size() << ", passes: " << passes << std::endl
+	   << "Classical evaluation: " << std::fixed << std::setprecision(1) << plain << " ns per call" << std::endl;
+
+	if (NNUE::enabled()) {
+		start = steady_clock::now();
+		for (int i = 0; i < passes; ++i) {
+			for (const Position& pos : positions) {
+				sink = sink + NNUE::evaluate(pos);
+			}
+		}
+		ss << "NNUE evaluation: " << duration_cast<nanoseconds>(steady_clock::now() - start).count() / calls
+		   << " ns per call" << std::endl;
+	}
+
+	const std::pair<const char*, int> terms[] = {
+		{ "Material", MATERIAL }, { "Pawns", PAWN }, { "Attacks", ATTACKS },
+		{ "Knights", KNIGHT }, { "Bishops", BISHOP }, { "Rooks", ROOK },
+		{ "Queens", QUEEN }, { "King safety", KING }, { "Scaling", SCALING },
+	};
+	double termTotal = 0;
+	for (const auto& [name, t] : terms) {
+		termTotal += std::max(Trace::nanos[t] / calls - overhead, 0.0);
+	}
+
+	// The profiled calls also pay for the timers, one clock read per term
+	ss << "Profiled: " << profiled << " ns per call, " << overhead << " ns per term for the timer" << std::endl
+	   << "         Term | ns/call |     %" << std::endl
+	   << " -------------+---------+-------" << std::endl;
+	for (const auto& [name, t] : terms) {
+		double ns = std::max(Trace::nanos[t] / calls - overhead, 0.0);
+		ss << std::setw(13) << name << " | " << std::setw(7) << ns << " | "
+		   << std::setw(5) << 100.0 * ns / termTotal << std::endl;
+	}
+	return ss.str();
+}
+
+void EvalCache::init() {
+	size_t mb = get_option_int("Eval Cache");
+	for (Thread* th : Threads.threads) {
+		th->evalCache.resize(mb);
+	}
+}
+
+void EvalCache::on_size_change(const Option&) {
+	init();
+}
+
+void EvalCache::resize(size_t mb) {
+	size_t n = mb * 1024 * 1024 / sizeof(uint64_t);
+	// Round down to a power of 2 for the index mask
+	while (n & (n - 1)) n &= n - 1;
+	std::vector<uint64_t>(n).swap(entries);
+}
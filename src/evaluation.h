@@ -1,15 +1,120 @@
-#ifndef EVALUATION_H_INCLUDED
-#define EVALUATION_H_INCLUDED
-
-#include "position.h"
-#include "types.h"
-
-namespace PSQT {
-	extern Score PieceValue[PIECE_NB];
-	extern Score psq[PIECE_NB][SQ_NB];
-	void init();
-}
-
-Value eval (const Position& pos);
-
-#endif
+#ifndef EVALUATION_H_INCLUDED
+#define EVALUATION_H_INCLUDED
+
+#include "position.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+struct Option;
+
+namespace PSQT {
+	extern Score PieceValue[PIECE_NB];
+	extern Score psq[PIECE_NB][SQ_NB];
+	void init();
+}
+
+namespace Eval {
+	// Bonus of the side to move, added to the classical evaluation after
+	// tapering
+	constexpr Value Tempo = Value(20);
+
+	// Read the evaluation parameters from the tuning options
+	void init();
+	void on_param_change(const Option& op);
+
+	// Table of the classical evaluation terms of a position, for "eval"
+	std::string trace(const Position& pos);
+
+	// Time the classical evaluation of the positions of an EPD or FEN file,
+	// in total and by term, for "evalbench"
+	std::string profile(std::istream& epd, int passes);
+
+	// The white minus black score of the position before tapering, with
+	// the phase and the endgame scale factor, and the counts of the weights
+	// in Tune::Coefficients. False for the specialized endgames, which do
+	// not use the weights.
+	bool linearize(const Position& pos, Score& score, int& phase, int& scaleFactor);
+
+	// Evaluate n positions with threads, as eval() outside of a search:
+	// scores[i] is the value of positions[i] for its side to move. Threads
+	// take blocks of BatchBlock consecutive positions in turn.
+	constexpr size_t BatchBlock = 1024;
+	void evaluate_batch(const PackedPosition* positions, size_t n, Value* scores, int threads);
+}
+
+// Static evaluation from the point of view of the side to move. With a
+// window, the classical evaluation may stop after material and
+// piece-square scores when they are beyond it by the lazy margin; the
+// value is then only good for deciding against alpha or beta, and lazy is
+// set: it must not be stored as the static evaluation of the position.
+Value eval(const Position& pos, Value alpha, Value beta, bool& lazy);
+
+inline Value eval(const Position& pos, Value alpha = -VALUE_INFINITE, Value beta = VALUE_INFINITE) {
+	bool lazy;
+	return eval(pos, alpha, beta, lazy);
+}
+
+// Early exits of the lazy evaluation in the current search. When sampling,
+// one exit out of SampleRate is compared with the full evaluation: the sum
+// of the absolute errors, and the number of values misjudged against alpha
+// or beta.
+struct LazyEvalStats {
+	static constexpr uint64_t SampleRate = 16;
+
+	void reset() { evals = exits = samples = misjudged = totalError = 0; }
+
+	bool sampling = false;
+	uint64_t evals = 0;
+	uint64_t exits = 0;
+	uint64_t samples = 0;
+	uint64_t misjudged = 0;
+	uint64_t totalError = 0;
+};
+
+// EvalCache is a direct-mapped cache of static evaluations, one per thread,
+// consulted by eval() for the positions searched by that thread. Each entry
+// packs the upper 48 bits of the key with the 16 bit value.
+class EvalCache {
+public:
+	// Size every thread's cache from the "Eval Cache" option, in MB. A size
+	// of 0 disables the cache.
+	static void init();
+	static void on_size_change(const Option& op);
+
+	void resize(size_t mb);
+
+	bool probe(Key key, Value& v) {
+		if (entries.empty()) return false;
+		uint64_t data = entries[key & (entries.size() - 1)];
+		if ((data ^ key) >> 16) {
+			++missCount;
+			return false;
+		}
+		++hitCount;
+		v = Value(int16_t(data & 0xFFFF));
+		return true;
+	}
+
+	void store(Key key, Value v) {
+		if (entries.empty()) return;
+		entries[key & (entries.size() - 1)] = (key & ~0xFFFFULL) | uint16_t(int16_t(v));
+	}
+
+	bool enabled() const { return !entries.empty(); }
+
+	// Statistics of the current search
+	void reset_stats() { hitCount = missCount = 0; }
+	uint64_t hits() const { return hitCount; }
+	uint64_t misses() const { return missCount; }
+
+private:
+	std::vector<uint64_t> entries;
+	uint64_t hitCount = 0;
+	uint64_t missCount = 0;
+};
+
+#endif
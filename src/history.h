@@ -0,0 +1,51 @@
+#ifndef HISTORY_H_INCLUDED
+#define HISTORY_H_INCLUDED
+
+#include "types.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// StatsEntry is a history counter with a "gravity" update: the bonus is
+// scaled down as the entry gets close to its bound D, so the value always
+// stays within [-D, D] and recent results outweigh old ones.
+template<int D>
+struct StatsEntry {
+	int16_t val;
+
+	operator int() const { return val; }
+
+	void update(int bonus) {
+		bonus = bonus < -D ? -D : bonus > D ? D : bonus;
+		val += bonus - val * std::abs(bonus) / D;
+	}
+};
+
+// Butterfly history of quiet moves, indexed by [color][from_to(move)]
+typedef StatsEntry<7183> ButterflyHistory[COLOR_NB][int(SQ_NB) * int(SQ_NB)];
+
+// Last quiet move that refuted a move, indexed by [piece][to] of that move
+typedef Move CounterMoveHistory[PIECE_NB][SQ_NB];
+
+// History of a quiet move [piece][to] given one previous move
+typedef StatsEntry<29952> PieceToHistory[PIECE_NB][SQ_NB];
+
+// History of captures, indexed by [moved piece][to][captured piece type].
+// Promotions without capture use NO_PIECE_TYPE.
+typedef StatsEntry<10692> CapturePieceToHistory[PIECE_NB][SQ_NB][PIECE_TYPE_NB];
+
+// Continuation history, indexed by [piece][to] of a previous move. The
+// search stack keeps a pointer to the PieceToHistory of each move played.
+typedef PieceToHistory ContinuationHistory[PIECE_NB][SQ_NB];
+
+// Scale all the entries of a history table by num / den, used to age the
+// tables between two searches instead of clearing them.
+template<typename T>
+void age_history(T& table, int num, int den) {
+	auto* p = reinterpret_cast<int16_t*>(&table);
+	for (size_t i = 0; i < sizeof(T) / sizeof(int16_t); ++i) {
+		p[i] = int16_t(p[i] * num / den);
+	}
+}
+
+#endif
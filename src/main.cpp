@@ -1,19 +1,27 @@
-#include "bitboard.h"
-#include "option.h"
-#include "position.h"
-#include "thread.h"
-#include "transposition.h"
-#include "evaluation.h"
-#include "uci.h"
-
-int main(int argc, char **argv)
-{
-	Threads.init();
-	bitboard::init();
-	PSQT::init();
-	Option::init();
-	Position::init();
-	ttable.init(); // maybe put it somewhere else
-
-	return UCI::main(argc, argv);
-}
+#include "bitboard.h"
+#include "endgame.h"
+#include "option.h"
+#include "position.h"
+#include "search.h"
+#include "thread.h"
+#include "transposition.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "uci.h"
+
+int main(int argc, char **argv)
+{
+	Threads.init();
+	bitboard::init();
+	PSQT::init();
+	Option::init();
+	Search::init();
+	Eval::init();
+	Position::init();
+	Endgames::init();
+	ttable.init(); // maybe put it somewhere else
+	EvalCache::init();
+	NNUE::init();
+
+	return UCI::main(argc, argv);
+}
@@ -0,0 +1,65 @@
+#include "material.h"
+#include "endgame.h"
+#include "position.h"
+#include "thread.h"
+#include "types.h"
+#include "weights.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Scale factor with one pawn and no real material advantage
+constexpr int ScaleFactorOnePawn = 48;
+
+// Table for positions which are not searched by a thread, e.g. in tests or
+// in Eval::evaluate_batch(), one per system thread
+thread_local Material::Table DefaultTable;
+
+Score imbalance(const Position& pos, Color us) {
+	return pos.count(make_piece(us, BISHOP)) >= 2 ? BonusBishopPair : SCORE_ZERO;
+}
+
+} // namespace
+
+namespace Material {
+
+Entry* probe(const Position& pos) {
+	Key key = pos.material_key();
+	Table& table = pos.this_thread() ? pos.this_thread()->materialTable : DefaultTable;
+	Entry* e = table[key];
+
+	if (e->key == key) return e;
+
+	std::memset(e, 0, sizeof(Entry));
+	e->key = key;
+	e->factor[WHITE] = e->factor[BLACK] = uint8_t(SCALE_FACTOR_NORMAL);
+
+	// Phase factor: 0 (Endgame) to 128 (Midgame)
+	int npm = std::clamp(int(pos.non_pawn_material()), int(EndgameLimit), int(MidgameLimit));
+	e->gamePhase = ((npm - EndgameLimit) * 128) / (MidgameLimit - EndgameLimit);
+
+	// Known endgames are evaluated by their own function
+	if ((e->evaluationFunction = Endgames::probe(pos)) != nullptr) return e;
+
+	// Without pawns, a side needs more than a minor piece of advantage to
+	// win, and it needs at least a rook's worth of material
+	for (Color us : { WHITE, BLACK }) {
+		Color them = flip_color(us);
+		Value npmUs = pos.non_pawn_material(us);
+		Value npmThem = pos.non_pawn_material(them);
+
+		if (!pos.count(make_piece(us, PAWN)) && npmUs - npmThem <= BishopValueMg) {
+			e->factor[us] = uint8_t(npmUs < RookValueMg ? SCALE_FACTOR_DRAW
+			                      : npmThem <= BishopValueMg ? 4 : 14);
+		}
+		else if (pos.count(make_piece(us, PAWN)) == 1 && npmUs - npmThem <= BishopValueMg) {
+			e->factor[us] = uint8_t(ScaleFactorOnePawn);
+		}
+	}
+
+	e->imbalanceScore = imbalance(pos, WHITE) - imbalance(pos, BLACK);
+	return e;
+}
+
+} // namespace Material
@@ -0,0 +1,43 @@
+#ifndef MATERIAL_H_INCLUDED
+#define MATERIAL_H_INCLUDED
+
+#include "endgame.h"
+#include "misc.h"
+#include "position.h"
+#include "types.h"
+#include <cstdint>
+
+namespace Material {
+
+// Entry holds the terms which only depend on the material of a position:
+// the game phase, the material imbalance, the scale factor of the endgame
+// score for each side, and the specialized evaluation function if the
+// material is a known endgame.
+struct Entry {
+	Score imbalance() const { return imbalanceScore; }
+	int game_phase() const { return gamePhase; }
+	bool specialized_eval_exists() const { return evaluationFunction != nullptr; }
+	ScaleFactor scale_factor(Color c) const { return ScaleFactor(factor[c]); }
+
+	// Value of the known endgame, from White's point of view
+	Value evaluate(const Position& pos) const {
+		Value v = evaluationFunction->fn(pos, evaluationFunction->strongSide);
+		return evaluationFunction->strongSide == WHITE ? v : -v;
+	}
+
+	Key key;
+	const Endgames::Endgame* evaluationFunction;
+	Score imbalanceScore; // from White's point of view
+	int gamePhase;        // 0 (endgame) to 128 (midgame)
+	uint8_t factor[COLOR_NB];
+};
+
+typedef HashTable<Entry, 8192> Table;
+
+// Look up the material of the position in the table of its thread,
+// computing it on a miss
+Entry* probe(const Position& pos);
+
+} // namespace Material
+
+#endif
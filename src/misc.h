@@ -0,0 +1,19 @@
+#ifndef MISC_H_INCLUDED
+#define MISC_H_INCLUDED
+
+#include "types.h"
+#include <cstdint>
+#include <vector>
+
+// HashTable is a direct-mapped cache of Size entries (a power of 2),
+// indexed by the low bits of a key. Each entry stores its full key, and
+// the caller recomputes the entry when the keys differ.
+template<class Entry, int Size>
+struct HashTable {
+	Entry* operator[](Key key) { return &table[uint32_t(key) & (Size - 1)]; }
+
+private:
+	std::vector<Entry> table = std::vector<Entry>(Size);
+};
+
+#endif
@@ -0,0 +1,384 @@
+#include "nnue.h"
+#include "bitboard.h"
+#include "evaluation.h"
+#include "option.h"
+#include "position.h"
+#include "types.h"
+#include "uci.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+namespace NNUE {
+
+namespace {
+
+// File header: magic, then a hash of the architecture so that a network
+// of other dimensions is rejected
+constexpr uint32_t Magic = 0x4555'4E4E; // "NNUE"
+constexpr uint32_t ArchHash = uint32_t(Features) ^ (HalfDimensions << 8)
+                            ^ (Hidden1 << 16) ^ (Hidden2 << 22) ^ (PSQTBuckets << 28);
+
+// Hidden layers are scaled by 2^WeightScaleBits, and the output by OutputScale
+constexpr int WeightScaleBits = 6;
+constexpr int OutputScale = 16;
+
+// Longest chain of states updated incrementally before refreshing
+constexpr int MaxUpdatePath = 64;
+
+struct Network {
+	std::vector<int16_t> ftBiases = std::vector<int16_t>(HalfDimensions);
+	std::vector<int16_t> ftWeights = std::vector<int16_t>(size_t(Features) * HalfDimensions);
+	std::vector<int32_t> ftPsqtWeights = std::vector<int32_t>(size_t(Features) * PSQTBuckets);
+
+	int32_t l1Biases[Hidden1];
+	int8_t l1Weights[Hidden1][2 * HalfDimensions];
+	int32_t l2Biases[Hidden2];
+	int8_t l2Weights[Hidden2][Hidden1];
+	int32_t outBias;
+	int8_t outWeights[Hidden2];
+};
+
+std::unique_ptr<Network> Net;
+bool UseNNUE = false;
+
+// Feature of a piece (king excluded) from the point of view of perspective,
+// whose king is on ksq. Black sees the board with the ranks flipped.
+int make_index(Color perspective, Square s, Piece pc, Square ksq) {
+	int orient = perspective == WHITE ? 0 : 56;
+	int pidx = (get_piece_type(pc) - PAWN) * 2 + (get_color(pc) != perspective);
+	return (int(ksq) ^ orient) * 640 + pidx * 64 + (int(s) ^ orient);
+}
+
+// --- Kernels ---
+
+void add_row(int16_t* acc, const int16_t* w) {
+#if defined(__AVX2__)
+	for (int i = 0; i < HalfDimensions; i += 16) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, b));
+	}
+#elif defined(__SSE4_1__)
+	for (int i = 0; i < HalfDimensions; i += 8) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, b));
+	}
+#else
+	for (int i = 0; i < HalfDimensions; ++i) acc[i] = int16_t(acc[i] + w[i]);
+#endif
+}
+
+void sub_row(int16_t* acc, const int16_t* w) {
+#if defined(__AVX2__)
+	for (int i = 0; i < HalfDimensions; i += 16) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, b));
+	}
+#elif defined(__SSE4_1__)
+	for (int i = 0; i < HalfDimensions; i += 8) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, b));
+	}
+#else
+	for (int i = 0; i < HalfDimensions; ++i) acc[i] = int16_t(acc[i] - w[i]);
+#endif
+}
+
+// Clamp the accumulator to [0, 127], the input of the first hidden layer
+void clipped_relu(const int16_t* in, uint8_t* out) {
+#if defined(__AVX2__)
+	const __m256i zero = _mm256_setzero_si256();
+	for (int i = 0; i < HalfDimensions; i += 32) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+		// packs works on 128 bit lanes, restore the order of the words
+		__m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_max_epi8(p, zero));
+	}
+#elif defined(__SSE4_1__)
+	const __m128i zero = _mm_setzero_si128();
+	for (int i = 0; i < HalfDimensions; i += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+	}
+#else
+	for (int i = 0; i < HalfDimensions; ++i) out[i] = uint8_t(std::clamp(int(in[i]), 0, 127));
+#endif
+}
+
+// Dot product of n inputs in [0, 127] with int8 weights, n a multiple of 32
+int32_t dot(const uint8_t* in, const int8_t* w, int n) {
+#if defined(__AVX2__)
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i sum = _mm256_setzero_si256();
+	for (int i = 0; i < n; i += 32) {
+		__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+		// Pairs of products fit in int16 since the inputs are at most 127
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, y), ones));
+	}
+	__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+	return _mm_cvtsi128_si32(s);
+#elif defined(__SSE4_1__)
+	const __m128i ones = _mm_set1_epi16(1);
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < n; i += 16) {
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, y), ones));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+#else
+	int32_t sum = 0;
+	for (int i = 0; i < n; ++i) sum += int32_t(in[i]) * w[i];
+	return sum;
+#endif
+}
+
+// Hidden layer: affine transform followed by a clipped ReLU
+template<int In, int Out>
+void hidden_layer(const uint8_t* in, const int32_t* biases, const int8_t (*weights)[In], uint8_t* out) {
+	for (int i = 0; i < Out; ++i) {
+		int32_t v = biases[i] + dot(in, weights[i], In);
+		out[i] = uint8_t(std::clamp(v >> WeightScaleBits, 0, 127));
+	}
+}
+
+// --- Accumulator ---
+
+void add_feature(Accumulator& acc, Color perspective, int idx) {
+	add_row(acc.accumulation[perspective], &Net->ftWeights[size_t(idx) * HalfDimensions]);
+	for (int b = 0; b < PSQTBuckets; ++b) {
+		acc.psqtAccumulation[perspective][b] += Net->ftPsqtWeights[size_t(idx) * PSQTBuckets + b];
+	}
+}
+
+void remove_feature(Accumulator& acc, Color perspective, int idx) {
+	sub_row(acc.accumulation[perspective], &Net->ftWeights[size_t(idx) * HalfDimensions]);
+	for (int b = 0; b < PSQTBuckets; ++b) {
+		acc.psqtAccumulation[perspective][b] -= Net->ftPsqtWeights[size_t(idx) * PSQTBuckets + b];
+	}
+}
+
+void refresh_accumulator(const Position& pos, Color perspective) {
+	Accumulator& acc = pos.state()->accumulator;
+	Square ksq = lsb(pos.pieces(perspective, KING));
+
+	std::memcpy(acc.accumulation[perspective], Net->ftBiases.data(), sizeof(acc.accumulation[perspective]));
+	std::memset(acc.psqtAccumulation[perspective], 0, sizeof(acc.psqtAccumulation[perspective]));
+
+	Bitboard b = pos.pieces() & ~pos.pieces(KING);
+	while (b) {
+		Square s = pop_lsb(b);
+		add_feature(acc, perspective, make_index(perspective, s, pos.piece_on(s), ksq));
+	}
+	acc.computed[perspective] = true;
+}
+
+// Bring the accumulator of the position up to date by applying the moves
+// since the nearest computed state. All the features of a side depend on
+// its king square, so a move of that king needs a full refresh.
+void update_accumulator(const Position& pos, Color perspective) {
+	StateInfo* path[MaxUpdatePath];
+	int n = 0;
+	Piece king = make_piece(perspective, KING);
+
+	for (StateInfo* st = pos.state(); !st->accumulator.computed[perspective]; st = st->prev) {
+		const DirtyPiece& dp = st->dirtyPiece;
+		bool kingMoved = false;
+		for (int i = 0; i < dp.dirty_num; ++i) kingMoved |= dp.piece[i] == king;
+
+		if (kingMoved || !st->prev || n == MaxUpdatePath) {
+			refresh_accumulator(pos, perspective);
+			return;
+		}
+		path[n++] = st;
+	}
+
+	// Update the states of the path from the oldest, so that siblings of the
+	// searched moves find a computed parent
+	Square ksq = lsb(pos.pieces(perspective, KING));
+	for (int j = n - 1; j >= 0; --j) {
+		Accumulator& acc = path[j]->accumulator;
+		const Accumulator& prev = path[j]->prev->accumulator;
+		std::memcpy(acc.accumulation[perspective], prev.accumulation[perspective], sizeof(acc.accumulation[perspective]));
+		std::memcpy(acc.psqtAccumulation[perspective], prev.psqtAccumulation[perspective], sizeof(acc.psqtAccumulation[perspective]));
+
+		const DirtyPiece& dp = path[j]->dirtyPiece;
+		for (int i = 0; i < dp.dirty_num; ++i) {
+			if (get_piece_type(dp.piece[i]) == KING) continue;
+			if (dp.from[i] != SQ_NONE) remove_feature(acc, perspective, make_index(perspective, dp.from[i], dp.piece[i], ksq));
+			if (dp.to[i] != SQ_NONE) add_feature(acc, perspective, make_index(perspective, dp.to[i], dp.piece[i], ksq));
+		}
+		acc.computed[perspective] = true;
+	}
+}
+
+// --- Serialization ---
+
+template<typename T>
+bool read(std::istream& is, T* p, size_t n) {
+	is.read(reinterpret_cast<char*>(p), std::streamsize(sizeof(T) * n));
+	return bool(is);
+}
+
+template<typename T>
+bool write(std::ostream& os, const T* p, size_t n) {
+	os.write(reinterpret_cast<const char*>(p), std::streamsize(sizeof(T) * n));
+	return bool(os);
+}
+
+std::string option_string(const char* name) {
+	return std::get<std::string>(Options[name].value);
+}
+
+} // namespace
+
+bool load(std::istream& is) {
+	uint32_t magic, hash;
+	if (!read(is, &magic, 1) || !read(is, &hash, 1) || magic != Magic || hash != ArchHash) {
+		return false;
+	}
+
+	auto net = std::make_unique<Network>();
+	if (   !read(is, net->ftBiases.data(), net->ftBiases.size())
+	    || !read(is, net->ftWeights.data(), net->ftWeights.size())
+	    || !read(is, net->ftPsqtWeights.data(), net->ftPsqtWeights.size())
+	    || !read(is, net->l1Biases, Hidden1)
+	    || !read(is, &net->l1Weights[0][0], size_t(Hidden1) * 2 * HalfDimensions)
+	    || !read(is, net->l2Biases, Hidden2)
+	    || !read(is, &net->l2Weights[0][0], size_t(Hidden2) * Hidden1)
+	    || !read(is, &net->outBias, 1)
+	    || !read(is, net->outWeights, Hidden2)) {
+		return false;
+	}
+
+	Net = std::move(net);
+	return true;
+}
+
+bool save(std::ostream& os) {
+	if (!Net) return false;
+	return write(os, &Magic, 1) && write(os, &ArchHash, 1)
+	    && write(os, Net->ftBiases.data(), Net->ftBiases.size())
+	    && write(os, Net->ftWeights.data(), Net->ftWeights.size())
+	    && write(os, Net->ftPsqtWeights.data(), Net->ftPsqtWeights.size())
+	    && write(os, Net->l1Biases, Hidden1)
+	    && write(os, &Net->l1Weights[0][0], size_t(Hidden1) * 2 * HalfDimensions)
+	    && write(os, Net->l2Biases, Hidden2)
+	    && write(os, &Net->l2Weights[0][0], size_t(Hidden2) * Hidden1)
+	    && write(os, &Net->outBias, 1)
+	    && write(os, Net->outWeights, Hidden2);
+}
+
+void use_default() {
+	auto net = std::make_unique<Network>();
+
+	// Only the PSQT output is set: a piece is worth its tapered PSQT score,
+	// from full endgame in bucket 0 to full midgame in the last bucket. The
+	// king square and the hidden layers are left for a trained network.
+	for (int ksq = 0; ksq < SQ_NB; ++ksq) {
+		for (PieceType pt = PAWN; pt <= QUEEN; ++pt) {
+			for (Color c : { WHITE, BLACK }) {
+				for (Square s = SQ_A1; s <= SQ_H8; ++s) {
+					// Seen from White: our pieces are white, theirs are black
+					Score score = c == WHITE ? PSQT::psq[make_piece(WHITE, pt)][s]
+					                         : -PSQT::psq[make_piece(BLACK, pt)][s];
+					int idx = make_index(WHITE, s, make_piece(c, pt), Square(ksq));
+					for (int b = 0; b < PSQTBuckets; ++b) {
+						int v = (mg_value(score) * b + eg_value(score) * (PSQTBuckets - 1 - b)) / (PSQTBuckets - 1);
+						net->ftPsqtWeights[size_t(idx) * PSQTBuckets + b] = v * OutputScale;
+					}
+				}
+			}
+		}
+	}
+
+	Net = std::move(net);
+}
+
+void init() {
+	std::string type = option_string("EvalType");
+	std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c){ return std::tolower(c); });
+	UseNNUE = type == "nnue";
+
+	if (!UseNNUE) {
+		Net.reset();
+		return;
+	}
+
+	std::string file = option_string("EvalFile");
+	if (file.empty() || file == "<empty>") {
+		use_default();
+		sync_cout << "info string NNUE evaluation using the embedded untrained network (material and PSQT only)" << sync_endl;
+		return;
+	}
+
+	std::ifstream ifs(file, std::ios::binary);
+	if (ifs && load(ifs)) {
+		sync_cout << "info string NNUE evaluation using " << file << sync_endl;
+	}
+	else {
+		use_default();
+		sync_cout << "info string failed to load " << file << ", NNUE evaluation using the embedded untrained network (material and PSQT only)" << sync_endl;
+	}
+}
+
+void on_option_change(const Option&) {
+	init();
+	// Cached evaluations come from the previous evaluator
+	EvalCache::init();
+}
+
+bool enabled() {
+	return UseNNUE;
+}
+
+Value evaluate(const Position& pos) {
+	assert(Net);
+
+	update_accumulator(pos, WHITE);
+	update_accumulator(pos, BLACK);
+
+	const Accumulator& acc = pos.state()->accumulator;
+	Color us = pos.side_to_move();
+	Color them = flip_color(us);
+	int bucket = std::min((__builtin_popcountll(pos.pieces()) - 1) / 4, PSQTBuckets - 1);
+
+	alignas(32) uint8_t input[2 * HalfDimensions];
+	clipped_relu(acc.accumulation[us], input);
+	clipped_relu(acc.accumulation[them], input + HalfDimensions);
+
+	alignas(32) uint8_t hidden1[Hidden1];
+	alignas(32) uint8_t hidden2[Hidden2];
+	hidden_layer<2 * HalfDimensions, Hidden1>(input, Net->l1Biases, Net->l1Weights, hidden1);
+	hidden_layer<Hidden1, Hidden2>(hidden1, Net->l2Biases, Net->l2Weights, hidden2);
+
+	int32_t positional = Net->outBias + dot(hidden2, Net->outWeights, Hidden2);
+	int32_t psqt = (acc.psqtAccumulation[us][bucket] - acc.psqtAccumulation[them][bucket]) / 2;
+
+	int v = (psqt + positional) / OutputScale;
+	return Value(std::clamp(v, int(VALUE_MATED_IN_MAX_PLY) + 1, int(VALUE_MATE_IN_MAX_PLY) - 1));
+}
+
+} // namespace NNUE
@@ -0,0 +1,65 @@
+#ifndef NNUE_H_INCLUDED
+#define NNUE_H_INCLUDED
+
+#include "types.h"
+#include <cstdint>
+#include <iostream>
+
+class Position;
+struct Option;
+
+namespace NNUE {
+
+// Network architecture: a HalfKP feature transformer (king square x piece
+// x square, from each side's point of view) of HalfDimensions neurons per
+// side, two hidden layers and one output. The transformer also has a
+// direct PSQT output with one bucket per range of piece count.
+constexpr int Features = 64 * 10 * 64;
+constexpr int HalfDimensions = 256;
+constexpr int Hidden1 = 32;
+constexpr int Hidden2 = 32;
+constexpr int PSQTBuckets = 8;
+
+// Select the network from the "EvalType" and "EvalFile" options. An
+// "EvalFile" of <empty> uses the embedded default network.
+void init();
+void on_option_change(const Option& op);
+
+// Is the network used by eval()?
+bool enabled();
+
+// Load a network in the format written by save(), replacing the current
+// one only if the whole stream is valid
+bool load(std::istream& is);
+bool save(std::ostream& os);
+
+// Build the embedded default network, whose PSQT output reproduces the
+// material and piece-square tables of the hand-crafted evaluation. It is
+// not a trained network: the hidden layers are zero, and it knows nothing
+// beyond those tables.
+void use_default();
+
+// Evaluation from the side to move point of view. The accumulators of
+// the position are brought up to date first.
+Value evaluate(const Position& pos);
+
+} // namespace NNUE
+
+// Pieces changed by a move, for the incremental update of the accumulator.
+// from is SQ_NONE for a piece put on the board, to for a piece removed.
+struct DirtyPiece {
+	int dirty_num;
+	Piece piece[3];
+	Square from[3];
+	Square to[3];
+};
+
+// Transformer output of a position, for each perspective. A state is only
+// computed when it is evaluated, from the nearest computed ancestor.
+struct Accumulator {
+	alignas(32) int16_t accumulation[COLOR_NB][NNUE::HalfDimensions];
+	int32_t psqtAccumulation[COLOR_NB][NNUE::PSQTBuckets];
+	bool computed[COLOR_NB];
+};
+
+#endif
@@ -1,52 +1,69 @@
-#include "option.h"
-#include "transposition.h"
-
-const std::string EMPTY = "<empty>";
-
-option_map_t Options;
-
-void Option::init() {
-	Options["Debug Log File"] << Option("Debug Log File", "string", EMPTY);
-	Options["Threads"] << Option("Threads", 1, 1, 1024);
-	Options["Hash"] << Option("Hash", 128, 1, 33554432, TranspositionTable::on_hash_change);
-	Options["Clear Hash"] << Option("Clear Hash");
-	Options["Ponder"] << Option("Ponder", "check", "false");
-	Options["EvalType"] << Option("EvalType", "string", EMPTY);
-}
-
-Option::Option(std::string name_, std::string type_, std::string defaultstr_, opt_func_t on_change_func) :
-	name(name_), type(type_), defaultvalue(defaultstr_), value(defaultstr_),
-	on_change(on_change_func)
-{}
-
-Option::Option(std::string name_, int defaultint_, int min_, int max_, opt_func_t on_change_func) :
-	name(name_), type("spin"), defaultvalue(defaultint_), value(defaultint_),
-	on_change(on_change_func), min(min_), max(max_)
-{}
-
-Option::Option(std::string name_, opt_func_t on_change_func) : name(name_),
-	type("button"), on_change(on_change_func) {}
-
-Option& operator<< (Option& l, const Option& r) {
-	l.name = r.name;
-	l.type = r.type;
-	l.defaultvalue = r.defaultvalue;
-	l.value = r.value;
-	l.min = r.min;
-	l.max = r.max;
-	return l;
-}
-
-std::ostream& operator<< (std::ostream& os, Option op) {
-	os << "option name " << op.name << " type " << op.type;
-	if (op.type == "spin") {
-		std::cout << " default " << std::get<int> (op.defaultvalue)
-			<< " min " << op.min << " max " << op.max;
-	} else if (op.type == "button") {
-		// not print anything
-	} else {
-		std::cout << " default " << std::get<std::string> (op.defaultvalue);
-	}
-	return os;
-}
-
+#include "option.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "search.h"
+#include "transposition.h"
+
+const std::string EMPTY = "<empty>";
+
+option_map_t Options;
+
+void Option::init() {
+	Options["Debug Log File"] << Option("Debug Log File", "string", EMPTY);
+	Options["Threads"] << Option("Threads", 1, 1, 1024);
+	Options["Hash"] << Option("Hash", 128, 1, 33554432, TranspositionTable::on_hash_change);
+	Options["Clear Hash"] << Option("Clear Hash");
+	Options["Eval Cache"] << Option("Eval Cache", 8, 0, 1024, EvalCache::on_size_change);
+	Options["Move Overhead"] << Option("Move Overhead", 10, 0, 5000);
+	Options["nodestime"] << Option("nodestime", 0, 0, 10000);
+	Options["Ponder"] << Option("Ponder", "check", "false");
+	Options["EvalType"] << Option("EvalType", "string", "classical", NNUE::on_option_change);
+	Options["EvalFile"] << Option("EvalFile", "string", EMPTY, NNUE::on_option_change);
+
+	// Search parameters exposed for tuning, in hundredths
+	Options["LMR Base"] << Option("LMR Base", 75, 0, 300, Search::on_param_change);
+	Options["LMR Divisor"] << Option("LMR Divisor", 225, 50, 1000, Search::on_param_change);
+	Options["LMP Base"] << Option("LMP Base", 300, 100, 2000, Search::on_param_change);
+	Options["LMP Factor"] << Option("LMP Factor", 100, 0, 400, Search::on_param_change);
+
+	// Evaluation parameters exposed for tuning, in centipawns
+	Options["Lazy Margin"] << Option("Lazy Margin", 400, 0, 3000, Eval::on_param_change);
+}
+
+Option::Option(std::string name_, std::string type_, std::string defaultstr_, opt_func_t on_change_func) :
+	name(name_), type(type_), defaultvalue(defaultstr_), value(defaultstr_),
+	on_change(on_change_func)
+{}
+
+Option::Option(std::string name_, int defaultint_, int min_, int max_, opt_func_t on_change_func) :
+	name(name_), type("spin"), defaultvalue(defaultint_), value(defaultint_),
+	on_change(on_change_func), min(min_), max(max_)
+{}
+
+Option::Option(std::string name_, opt_func_t on_change_func) : name(name_),
+	type("button"), on_change(on_change_func) {}
+
+Option& operator<< (Option& l, const Option& r) {
+	l.name = r.name;
+	l.type = r.type;
+	l.defaultvalue = r.defaultvalue;
+	l.value = r.value;
+	l.min = r.min;
+	l.max = r.max;
+	l.on_change = r.on_change;
+	return l;
+}
+
+std::ostream& operator<< (std::ostream& os, Option op) {
+	os << "option name " << op.name << " type " << op.type;
+	if (op.type == "spin") {
+		std::cout << " default " << std::get<int> (op.defaultvalue)
+			<< " min " << op.min << " max " << op.max;
+	} else if (op.type == "button") {
+		// not print anything
+	} else {
+		std::cout << " default " << std::get<std::string> (op.defaultvalue);
+	}
+	return os;
+}
+
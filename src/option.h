@@ -1,84 +1,89 @@
-#ifndef OPTION_H_INCLUDED
-#define OPTION_H_INCLUDED
-
-#include <cassert>
-#include <functional>
-#include <iostream>
-#include <map>
-#include <ostream>
-#include <string>
-#include <variant>
-
-struct Option;
-
-typedef std::function<void(const Option&)> opt_func_t;
-
-/**
- * @class Option
- * @brief Store an uci option
- *
- */
-struct Option {
-	/**
-	 * @brief Static init function of Option module. I want to use namespace
-	 * instead but the name Option is used for struct.
-	 */
-	static void init();
-
-	/**
-	 * @brief 
-	 *
-	 * @param name_ Option name
-	 * @param type_ Option type (check, string)
-	 * @param defaultstr_ default string value
-	 */
-	Option(std::string name_, std::string type_, std::string defaultstr_, opt_func_t func = nullptr);
-	/**
-	 * @brief Constructor for spin options
-	 *
-	 * @param name_ Option name
-	 * @param defaultint_ default int value
-	 * @param min_ minimum int value
-	 * @param max_ maximum int value
-	 */
-	Option(std::string name_, int defaultint_, int min_, int max_, opt_func_t func = nullptr);
-
-	/**
-	 * @brief Constructor for button options
-	 *
-	 */
-	Option(std::string name_, opt_func_t func = nullptr);
-
-	Option() = default;
-	Option(const Option&) = default;
-	Option& operator= (const Option&) = delete;
-
-	std::string name;
-	std::string type;
-	std::variant<std::string, int> defaultvalue;
-	std::variant<std::string, int> value;
-	int min, max;
-	opt_func_t on_change;
-};
-
-struct CaseInsensitiveCmp {
-	bool operator() (const std::string& a, const std::string& b) const {
-		return std::lexicographical_compare(a.begin(), a.end(),
-			b.begin(), b.end(), [](char x, char y) {
-				return tolower(x) < tolower(y);
-			});
-	}
-};
-typedef std::map<std::string, Option, CaseInsensitiveCmp> option_map_t;
-
-Option& operator<< (Option& l, const Option& r);
-std::ostream& operator<< (std::ostream& os, Option op);
-
-extern option_map_t Options;
-
-inline int get_option_hash() {
-	assert(Options.count("hash"));
-	return std::get<int> (Options["hash"].value);
-}
-
-#endif
+#ifndef OPTION_H_INCLUDED
+#define OPTION_H_INCLUDED
+
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <variant>
+
+struct Option;
+
+typedef std::function<void(const Option&)> opt_func_t;
+
+/**
+ * @class Option
+ * @brief Store an uci option
+ *
+ */
+struct Option {
+	/**
+	 * @brief Static init function of Option module. I want to use namespace
+	 * instead but the name Option is used for struct.
+	 */
+	static void init();
+
+	/**
+	 * @brief 
+	 *
+	 * @param name_ Option name
+	 * @param type_ Option type (check, string)
+	 * @param defaultstr_ default string value
+	 */
+	Option(std::string name_, std::string type_, std::string defaultstr_, opt_func_t func = nullptr);
+	/**
+	 * @brief Constructor for spin options
+	 *
+	 * @param name_ Option name
+	 * @param defaultint_ default int value
+	 * @param min_ minimum int value
+	 * @param max_ maximum int value
+	 */
+	Option(std::string name_, int defaultint_, int min_, int max_, opt_func_t func = nullptr);
+
+	/**
+	 * @brief Constructor for button options
+	 *
+	 */
+	Option(std::string name_, opt_func_t func = nullptr);
+
+	Option() = default;
+	Option(const Option&) = default;
+	Option& operator= (const Option&) = delete;
+
+	std::string name;
+	std::string type;
+	std::variant<std::string, int> defaultvalue;
+	std::variant<std::string, int> value;
+	int min, max;
+	opt_func_t on_change;
+};
+
+struct CaseInsensitiveCmp {
+	bool operator() (const std::string& a, const std::string& b) const {
+		return std::lexicographical_compare(a.begin(), a.end(),
+			b.begin(), b.end(), [](char x, char y) {
+				return tolower(x) < tolower(y);
+			});
+	}
+};
+typedef std::map<std::string, Option, CaseInsensitiveCmp> option_map_t;
+
+Option& operator<< (Option& l, const Option& r);
+std::ostream& operator<< (std::ostream& os, Option op);
+
+extern option_map_t Options;
+
+inline int get_option_hash() {
+	assert(Options.count("hash"));
+	return std::get<int> (Options["hash"].value);
+}
+
+inline int get_option_int(const std::string& name) {
+	assert(Options.count(name));
+	return std::get<int> (Options[name].value);
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "pawns.h"
+#include "bitboard.h"
+#include "position.h"
+#include "thread.h"
+#include "tune.h"
+#include "types.h"
+#include "weights.h"
+
+namespace {
+
+// Table for positions which are not searched by a thread, e.g. in tests or
+// in Eval::evaluate_batch(), one per system thread
+thread_local Pawns::Table DefaultTable;
+
+template<Color Us, Tracing T>
+Score evaluate(const Position& pos, Pawns::Entry* e) {
+	constexpr Color Them = ~Us;
+	constexpr Direction Up = Us == WHITE ? NORTH : SOUTH;
+	constexpr Direction Down = Us == WHITE ? SOUTH : NORTH;
+
+	Bitboard ourPawns = pos.pieces(Us, PAWN);
+	Bitboard theirPawns = pos.pieces(Them, PAWN);
+	Score score = SCORE_ZERO;
+
+	// Whole-board spans: squares in front of our pawns, and squares which
+	// our pawns can attack as they advance
+	Bitboard ourFront = front_span(Us, ourPawns);
+	Bitboard theirFront = front_span(Them, theirPawns);
+	Bitboard ourFiles = file_fill(ourPawns);
+
+	e->pawnAttacks[Us] = pawn_attacks_bb(Us, ourPawns);
+	e->pawnAttacksSpan[Us] = shift<EAST>(ourFront) | shift<WEST>(ourFront);
+
+	// 1. Isolated Pawn
+	// No pawns on adjacent files
+	Bitboard isolated = ourPawns & ~(shift<EAST>(ourFiles) | shift<WEST>(ourFiles));
+	score += ScoreIsolated * __builtin_popcountll(isolated);
+	if constexpr (T == TRACE) Tune::add(Tune::ISOLATED, Us, __builtin_popcountll(isolated));
+
+	// 2. Doubled Pawn
+	// Another pawn of ours on the same file, every one of them is penalized
+	Bitboard doubled = ourPawns & (ourFront | front_span(Them, ourPawns));
+	score += ScoreDoubled * __builtin_popcountll(doubled);
+	if constexpr (T == TRACE) Tune::add(Tune::DOUBLED, Us, __builtin_popcountll(doubled));
+
+	// 3. Backward Pawn
+	// Its stop square is attacked by an enemy pawn and cannot be defended by
+	// our pawns, which are all in front of it on the adjacent files
+	Bitboard weakStops = shift<Up>(ourPawns) & pawn_attacks_bb(Them, theirPawns) & ~e->pawnAttacksSpan[Us];
+	Bitboard backward = shift<Down>(weakStops) & ~isolated;
+	score += ScoreBackward * __builtin_popcountll(backward);
+	if constexpr (T == TRACE) Tune::add(Tune::BACKWARD, Us, __builtin_popcountll(backward));
+
+	// 4. Passed Pawn
+	// No enemy pawns in front on the same file or adjacent files. The pawns
+	// blocked on their own file are dropped at once, the few others are
+	// checked against their passed pawn mask, with a bonus by relative rank.
+	e->passedPawns[Us] = 0;
+	for (Bitboard b = ourPawns & ~theirFront; b; ) {
+		Square s = pop_lsb(b);
+		if (PassedPawnMask[Us][s] & theirPawns) continue;
+
+		e->passedPawns[Us] |= square_bb(s);
+		Rank r = relative_rank(Us, s);
+		score += BonusPassedPawn[r];
+		if constexpr (T == TRACE) Tune::add(Tune::Param(Tune::PASSED_PAWN + r), Us);
+	}
+
+	return score;
+}
+
+} // namespace
+
+namespace Pawns {
+
+template<Color Us, Tracing T>
+Score Entry::evaluate_shelter(const Position& pos, Square ksq) const {
+	constexpr Direction Up = Us == WHITE ? NORTH : SOUTH;
+	Score score = SCORE_ZERO;
+	const File f = get_file(ksq);
+	const Rank r = relative_rank(Us, ksq);
+
+	// King on the back rank, on the G file (Kingside) or the B/C files
+	// (Queenside)
+	if (r == RANK_1 && (f == FILE_G || f == FILE_B || f == FILE_C)) {
+		score += BonusKingSafety;
+		if constexpr (T == TRACE) Tune::add(Tune::KING_ON_CASTLED_FILE, Us);
+	}
+
+	// Pawn Shield (Mainly MG)
+	// Pawns on the 3 files around the king, one rank in front of it
+	if (r <= RANK_2) {
+		Bitboard shieldMask = (file_bb(f) | adjacent_files_bb(f)) & rank_bb(get_rank(ksq + Up));
+		int shieldCount = __builtin_popcountll(shieldMask & pos.pieces(Us, PAWN));
+		if (shieldCount == 3) score += ScorePawnShield;
+		else if (shieldCount < 2) score += ScoreNoPawnShield;
+		if constexpr (T == TRACE) {
+			if (shieldCount == 3) Tune::add(Tune::PAWN_SHIELD, Us);
+			else if (shieldCount < 2) Tune::add(Tune::NO_PAWN_SHIELD, Us);
+		}
+	}
+
+	return score;
+}
+
+template Score Entry::evaluate_shelter<WHITE, NO_TRACE>(const Position& pos, Square ksq) const;
+template Score Entry::evaluate_shelter<BLACK, NO_TRACE>(const Position& pos, Square ksq) const;
+
+Entry* probe(const Position& pos) {
+	Key key = pos.pawn_key();
+	Table& table = pos.this_thread() ? pos.this_thread()->pawnsTable : DefaultTable;
+	Entry* e = table[key];
+
+	if (e->key == key) return e;
+
+	e->key = key;
+	e->kingSquares[WHITE] = e->kingSquares[BLACK] = SQ_NONE;
+	e->scores[WHITE] = evaluate<WHITE, NO_TRACE>(pos, e);
+	e->scores[BLACK] = evaluate<BLACK, NO_TRACE>(pos, e);
+	return e;
+}
+
+void trace(const Position& pos) {
+	Entry e;
+	evaluate<WHITE, TRACE>(pos, &e);
+	evaluate<BLACK, TRACE>(pos, &e);
+	e.evaluate_shelter<WHITE, TRACE>(pos, lsb(pos.pieces(WHITE, KING)));
+	e.evaluate_shelter<BLACK, TRACE>(pos, lsb(pos.pieces(BLACK, KING)));
+}
+
+} // namespace Pawns
@@ -0,0 +1,56 @@
+#ifndef PAWNS_H_INCLUDED
+#define PAWNS_H_INCLUDED
+
+#include "misc.h"
+#include "position.h"
+#include "tune.h"
+#include "types.h"
+
+namespace Pawns {
+
+// Entry holds the pawn structure terms of a pawn configuration, and the
+// king shelter of the last king square seen with these pawns. All scores
+// are from the point of view of their color.
+struct Entry {
+	Score pawn_score(Color c) const { return scores[c]; }
+	Bitboard passed_pawns(Color c) const { return passedPawns[c]; }
+	Bitboard pawn_attacks(Color c) const { return pawnAttacks[c]; }
+	Bitboard pawn_attacks_span(Color c) const { return pawnAttacksSpan[c]; }
+
+	// The shelter only depends on the pawns and the king square, so it is
+	// recomputed only when the king has moved
+	template<Color Us>
+	Score king_safety(const Position& pos) {
+		Square ksq = lsb(pos.pieces(Us, KING));
+		if (kingSquares[Us] != ksq) {
+			kingSquares[Us] = ksq;
+			kingSafety[Us] = evaluate_shelter<Us>(pos, ksq);
+		}
+		return kingSafety[Us];
+	}
+
+	template<Color Us, Tracing T = NO_TRACE>
+	Score evaluate_shelter(const Position& pos, Square ksq) const;
+
+	Key key;
+	Score scores[COLOR_NB];
+	Bitboard passedPawns[COLOR_NB];
+	Bitboard pawnAttacks[COLOR_NB];
+	Bitboard pawnAttacksSpan[COLOR_NB];
+	Square kingSquares[COLOR_NB];
+	Score kingSafety[COLOR_NB];
+};
+
+typedef HashTable<Entry, 16384> Table;
+
+// Look up the pawn structure of the position in the table of its thread,
+// computing it on a miss
+Entry* probe(const Position& pos);
+
+// Count the weights of the pawn structure and king shelter terms of the
+// position in Tune::Coefficients, bypassing the table
+void trace(const Position& pos);
+
+} // namespace Pawns
+
+#endif
@@ -1,896 +1,1181 @@
-#include "position.h"
-#include "bitboard.h"
-#include "random.h"
-#include "types.h"
-// Đã xóa bits/floatn-common.h
-#include <cassert>
-#include <cstdlib>
-#include <cstring>
-#include <iostream>
-#include <sstream>
-#include <string>
-// Đã xóa unistd.h
-
-constexpr Piece Pieces[] = {	W_PAWN, W_ROOK, W_KNIGHT, W_BISHOP, W_QUEEN, W_KING,
-				B_PAWN, B_ROOK, B_KNIGHT, B_BISHOP, B_QUEEN, B_KING};
-
-namespace Zobrist {
-	Key psq[PIECE_NB][SQ_NB];
-	Key enpassant[FILE_NB];
-	Key castlingRights[CASTLING_RIGHT_NB];
-	Key side;
-	// Key noPawn;
-}
-
-void Position::init() {
-	for (int i = 0; i < PIECE_NB; ++i)
-		for (int j = 0; j < SQ_NB; ++j)
-			Zobrist::psq[i][j] = random_u64();
-	for (int i = 0; i < FILE_NB; ++i)
-		Zobrist::enpassant[i] = random_u64();
-	for (int i = 0; i < CASTLING_RIGHT_NB; ++i)
-		Zobrist::castlingRights[i] = random_u64();
-	Zobrist::side = random_u64();
-	// Zobrist::noPawn = random_u64();
-}
-
-void Position::set(std::string fenStr, StateInfo& st) {
-	std::istringstream ss(fenStr);
-	std::string piece_placement_str, castling_right_str, ep_str;
-	char active_color;
-	int halfmove_clock, full_move_number;
-	ss >> piece_placement_str >> active_color >> castling_right_str >> ep_str
-		>> halfmove_clock >> full_move_number;
-
-	// Piece board[SQ_NB];
-	// Bitboard byColorBB[COLOR_NB];
-	// Bitboard byTypeBB[PIECE_TYPE_NB];
-	// Color sideToMove;
-	// int ply;
-	// StateInfo *st;
-
-	// struct StateInfo {
-	// 	Key key;
-	// 	int castlingRights;
-	// 	int rule50;
-	// 	Piece capturedPiece;
-	// 	Move lastmove;
-	// 	Square epSquare;
-	// 	StateInfo *prev;
-	// };
-
-	// init position
-	assert(NO_PIECE == 0);
-	memset(this->board, NO_PIECE, sizeof(this->board));
-	memset(this->byColorBB, 0, sizeof(this->byColorBB));
-	memset(this->byTypeBB, 0, sizeof(this->byTypeBB));
-	this->st = &st;
-	this->ply = 0;
-
-	// init state info
-	st.key = 0;
-	st.castlingRights = 0;
-	st.rule50 = halfmove_clock;
-	st.capturedPiece = NO_PIECE;
-	st.lastmove = MOVE_NONE;
-	// st.epSquare = (ep_str == "-") ? SQ_NONE : str_to_square(ep_str);
-	st.prev = nullptr;
-
-	Square current_sq = SQ_A8;
-	for (char c : piece_placement_str) {
-		if ('0' <= c && c <= '9') {
-			current_sq += int(c - '0');
-		} else if (c == '/') {
-			current_sq -= 16;
-		} else {
-			Piece p = char_to_piece(c);
-			this->board[current_sq] = p;
-			act_bit(this->byColorBB[get_color(p)], current_sq);
-			act_bit(this->byTypeBB[get_piece_type(p)], current_sq);
-			st.key ^= Zobrist::psq[p][current_sq];
-			++current_sq;
-		}
-	}
-	assert(current_sq == SQ_A1 + 8);
-
-	this->sideToMove = (active_color == 'b') ? BLACK : WHITE;
-	if (this->sideToMove == BLACK) {
-		st.key ^= Zobrist::side;
-	}
-
-	for (char c : castling_right_str) {
-		st.castlingRights |= char_to_castling_rights(c);
-	}
-	st.key ^= Zobrist::castlingRights[st.castlingRights];
-
-	if (ep_str == "-") {
-		st.epSquare = SQ_NONE;
-	} else {
-		st.epSquare = str_to_square(ep_str);
-		st.key ^= Zobrist::enpassant[get_file(st.epSquare)];
-	}
-}
-
-void Position::put_piece(Piece pc, Square sq) {
-	if (pc == NO_PIECE) return;
-	this->board[sq] = pc;
-	act_bit(this->byColorBB[get_color(pc)], sq);
-	act_bit(this->byTypeBB[get_piece_type(pc)], sq);
-}
-
-void Position::remove_piece(Square sq) {
-	Piece pc = this->board[sq];
-	if (pc == NO_PIECE) return;
-	this->board[sq] = NO_PIECE;
-	dec_bit(this->byColorBB[get_color(pc)], sq);
-	dec_bit(this->byTypeBB[get_piece_type(pc)], sq);
-}
-
-void Position::move_piece(Square fr, Square to) {
-	assert (fr != to);
-	Piece pc = this->board[fr];
-	this->remove_piece(fr);
-	this->remove_piece(to);
-	this->put_piece(pc, to);
-}
-
-void Position::do_move(Move m, StateInfo& newSt) {
-	// Piece board[SQ_NB];
-	// Bitboard byColorBB[COLOR_NB];
-	// Bitboard byTypeBB[PIECE_TYPE_NB];
-	// Color sideToMove;
-	// int ply;
-	// StateInfo *st;
-
-	// 	Key key;
-	// 	int castlingRights;
-	// 	int rule50;
-	// 	Piece capturedPiece;
-	// 	Move lastmove;
-	// 	Square epSquare;
-	// 	StateInfo *prev;
-
-	newSt.key = this->st->key;
-	newSt.castlingRights = this->st->castlingRights;
-	newSt.rule50 = this->st->rule50;
-	newSt.capturedPiece = NO_PIECE;
-	newSt.lastmove = m;
-	newSt.epSquare = SQ_NONE;
-	newSt.prev = this->st;
-
-	Square fr_square = from_sq(m);
-	Square to_square = to_sq(m);
-	Piece fr_piece = this->board[fr_square];
-	Piece to_piece = this->board[to_square];
-	PieceType fr_piece_type = get_piece_type(fr_piece);
-
-	// undo key
-	if (fr_piece != NO_PIECE) {
-		newSt.key ^= Zobrist::psq[fr_piece][fr_square];
-	}
-	if (to_piece != NO_PIECE) {
-		newSt.key ^= Zobrist::psq[to_piece][to_square];
-		newSt.capturedPiece = to_piece;
-	}
-	if (this->st->epSquare != SQ_NONE) {
-		newSt.key ^= Zobrist::enpassant[get_file(this->st->epSquare)];
-	}
-	newSt.key ^= Zobrist::castlingRights[this->st->castlingRights];
-
-	// the final key update only handle from and to square hash, additional
-	// changes handled for each type
-	MoveType moveType = type_of(m);
-
-	switch (moveType) {
-		case PROMOTION: {
-			Piece pro_piece = make_piece(this->sideToMove, promotion_type(m));
-			this->remove_piece(fr_square);
-			this->remove_piece(to_square);
-			this->put_piece(pro_piece, to_square);
-		}	break;
-		case ENPASSANT: {
-			this->move_piece(fr_square, to_square);
-			Square eaten_pawn_sq = fr_square + Direction(get_file(to_square) - get_file(fr_square));
-			Piece eaten_pawn_pc = this->board[eaten_pawn_sq];
-			newSt.key ^= Zobrist::psq[eaten_pawn_pc][eaten_pawn_sq];
-			this->remove_piece(eaten_pawn_sq);
-
-			newSt.capturedPiece = eaten_pawn_pc;
-			newSt.key ^= Zobrist::enpassant[get_file(eaten_pawn_sq)];
-		}	break;
-		case CASTLING: {
-			Square rook_from, rook_to;
-			Rank rook_rank = get_initial_king_rank(this->sideToMove);
-			if (get_file(to_square) == FILE_C) { // queen side
-				rook_from = make_square(FILE_A, rook_rank);
-				rook_to = make_square(FILE_D, rook_rank);
-			} else {
-				rook_from = make_square(FILE_H, rook_rank);
-				rook_to = make_square(FILE_F, rook_rank);
-			}
-			Piece rook_pc = make_piece(this->sideToMove, ROOK);
-			newSt.key ^= Zobrist::psq[rook_pc][rook_from];
-			this->move_piece(rook_from, rook_to);
-			newSt.key ^= Zobrist::psq[rook_pc][rook_to];
-
-			this->move_piece(fr_square, to_square);
-
-			// lost all castling rights
-			newSt.castlingRights &= ~get_side(this->sideToMove);
-		}	break;
-		default:
-			this->move_piece(fr_square, to_square);
-			// check if this move is the pawn move up two step and set newSt.epSquare
-			if (fr_piece_type == PAWN
-			&& abs(get_rank(fr_square) - get_rank(to_square)) == 2) {
-				newSt.epSquare = to_square - push_pawn(this->sideToMove);
-			}
-			if (fr_piece_type == KING) {
-				newSt.castlingRights &= ~get_side(this->sideToMove);
-			} else if (fr_piece_type == ROOK) {
-				newSt.castlingRights &= ~(get_side(this->sideToMove) & get_rook_side(fr_square));
-			}
-			break;
-	}
-
-	if (fr_piece_type == PAWN || newSt.capturedPiece != NO_PIECE) {
-		newSt.rule50 = 0;
-	} else {
-		++newSt.rule50;
-	}
-
-	// update new key
-	Piece piece_to_add = fr_piece;
-	if (moveType == PROMOTION) {
-		piece_to_add = make_piece(this->sideToMove, promotion_type(m));
-	}
-	newSt.key ^= Zobrist::psq[piece_to_add][to_square];
-
-	if (newSt.epSquare != SQ_NONE) {
-		newSt.key ^= Zobrist::enpassant[get_file(newSt.epSquare)];
-	}
-	newSt.key ^= Zobrist::castlingRights[newSt.castlingRights];
-
-	// flip side
-	this->sideToMove = flip_color(this->sideToMove);
-	newSt.key ^= Zobrist::side;
-
-	this->st = &newSt;
-	++this->ply;
-}
-
-void Position::undo_move() {
-	Piece capturedPiece = this->st->capturedPiece;
-	int cr = this->st->castlingRights;
-	Square epSquare = this->st->epSquare;
-	Move lastmove = this->st->lastmove;
-	MoveType movetype = type_of(lastmove);
-
-	Color movingSide = flip_color(this->sideToMove);
-
-	Square fr_square = from_sq(lastmove);
-	Square to_square = to_sq(lastmove);
-	Piece fr_piece = movetype == PROMOTION ? make_piece(movingSide, PAWN) : this->board[to_square];
-	Piece to_piece = movetype == ENPASSANT ? NO_PIECE : capturedPiece;
-	// PieceType fr_piece_type = get_piece_type(fr_piece);
-
-	this->remove_piece(fr_square);
-	this->remove_piece(to_square);
-	this->put_piece(fr_piece, fr_square);
-	this->put_piece(to_piece, to_square);
-
-	if (movetype == CASTLING) {
-		Square rook_from, rook_to;
-		Rank rook_rank = get_initial_king_rank(movingSide);
-		if (get_file(to_square) == FILE_C) { // queen side
-			rook_from = make_square(FILE_A, rook_rank);
-			rook_to = make_square(FILE_D, rook_rank);
-		} else {
-			rook_from = make_square(FILE_H, rook_rank);
-			rook_to = make_square(FILE_F, rook_rank);
-		}
-		this->remove_piece(rook_to);
-		this->put_piece(make_piece(movingSide, ROOK), rook_from);
-	} else if (movetype == ENPASSANT) {
-		Square eaten_pawn_sq = fr_square + Direction(get_file(to_square) - get_file(fr_square));
-		Piece eaten_pawn_pc = make_piece(flip_color(movingSide), PAWN);
-		this->put_piece(eaten_pawn_pc, eaten_pawn_sq);
-	}
-
-	this->sideToMove = movingSide;
-	this->st = this->st->prev;
-	--this->ply;
-}
-
-void Position::generate_moves(svec<Move>& moves) {
-	moves.clear();
-
-	Color us = this->sideToMove;
-	Color them = flip_color(us);
-
-	Bitboard our_pieces = this->pieces(us);
-	Bitboard their_pieces = this->pieces(them);
-	Bitboard empty_squares = ~(our_pieces | their_pieces);
-
-	// --- PAWNS ---
-	Bitboard pawns = this->pieces(us, PAWN);
-	Direction up = push_pawn(us);
-	Rank promo_rank = get_initial_pawn_rank(them);
-	Rank start_rank = get_initial_pawn_rank(us);
-
-	// 1. Single Push
-	// Shift pawns 'up'. AND with empty squares.
-	Bitboard single_push = (us == WHITE ? (pawns << 8) : (pawns >> 8)) & empty_squares;
-
-	Bitboard b = single_push;
-	while (b) {
-		Square to = pop_lsb(b);
-		Square from = to - up;
-		
-		if (get_rank(from) == promo_rank) {
-			Move m = make_move(from, to);
-			m |= PROMOTION;
-			moves.push_back(act_promotion_type(m, QUEEN));
-			moves.push_back(act_promotion_type(m, ROOK));
-			moves.push_back(act_promotion_type(m, BISHOP));
-			moves.push_back(act_promotion_type(m, KNIGHT));
-		} else {
-			moves.push_back(make_move(from, to));
-		}
-	}
-
-	// 2. Double Push
-	// Shift single_push 'up' again. AND with empty squares. AND check rank.
-	// White: Rank 3 -> 4. Black: Rank 6 -> 5.
-	Bitboard double_push = (us == WHITE ? (single_push << 8) : (single_push >> 8)) & empty_squares;
-	// Mask specific ranks (Rank 4 for White, Rank 5 for Black)
-	double_push &= (us == WHITE ? 0x00000000FF000000ULL : 0x000000FF00000000ULL);
-
-	b = double_push;
-	while (b) {
-		Square to = pop_lsb(b);
-		moves.push_back(make_move(to - up - up, to));
-	}
-
-	// 3. Captures
-	// Left Capture
-	Bitboard captures = 0;
-	// Note: Simple shift logic, requires file masking to prevent wrapping A-file to H-file
-	if (us == WHITE) captures = ((pawns & ~FileMask[FILE_A]) << 7) & their_pieces;
-	else             captures = ((pawns & ~FileMask[FILE_A]) >> 9) & their_pieces;
-
-	b = captures;
-	while (b) {
-		Square to = pop_lsb(b);
-		// From square calculation depends on direction
-		Square from = (us == WHITE) ? (to - 7) : (to + 9);
-		
-		if (get_rank(from) == promo_rank) {
-			Move m = Move(make_move(from, to) | PROMOTION);
-			moves.push_back(act_promotion_type(m, QUEEN));
-			moves.push_back(act_promotion_type(m, ROOK));
-			moves.push_back(act_promotion_type(m, BISHOP));
-			moves.push_back(act_promotion_type(m, KNIGHT));
-		} else {
-			moves.push_back(make_move(from, to));
-		}
-	}
-
-	// Right Capture
-	if (us == WHITE) captures = ((pawns & ~FileMask[FILE_H]) << 9) & their_pieces;
-	else             captures = ((pawns & ~FileMask[FILE_H]) >> 7) & their_pieces;
-
-	b = captures;
-	while (b) {
-		Square to = pop_lsb(b);
-		Square from = (us == WHITE) ? (to - 9) : (to + 7);
-		
-		if (get_rank(from) == promo_rank) {
-			Move m = Move(make_move(from, to) | PROMOTION);
-			moves.push_back(act_promotion_type(m, QUEEN));
-			moves.push_back(act_promotion_type(m, ROOK));
-			moves.push_back(act_promotion_type(m, BISHOP));
-			moves.push_back(act_promotion_type(m, KNIGHT));
-		} else {
-			moves.push_back(make_move(from, to));
-		}
-	}
-
-	// 4. En Passant
-	if (this->st->epSquare != SQ_NONE) {
-		Square ep = this->st->epSquare;
-		// Check pawns that can capture EP (left and right of EP square)
-		// This effectively checks "pawns attacking epSquare" logic reversed
-		Bitboard attackers = this->pieces(us, PAWN);
-		// Check pawn to the "left" (file - 1)
-		if (get_file(ep) > FILE_A) {
-			Square from = ep - up - 1; // e.g., if ep is d3, from is c3 (white) or c4? 
-			// Better: Check if we have a pawn at [ep_file-1, current_rank]
-			Square l_pawn = make_square(File(get_file(ep)-1), Rank(get_rank(ep)-push_pawn_rank(us)));
-			if (this->piece_on(l_pawn) == make_piece(us, PAWN)) {
-				 Move m = make_move(l_pawn, ep);
-				 m |= ENPASSANT;
-				 moves.push_back(m);
-			}
-		}
-		if (get_file(ep) < FILE_H) {
-			Square r_pawn = make_square(File(get_file(ep)+1), Rank(get_rank(ep)-push_pawn_rank(us)));
-			if (this->piece_on(r_pawn) == make_piece(us, PAWN)) {
-				 Move m = make_move(r_pawn, ep);
-				 m |= ENPASSANT;
-				 moves.push_back(m);
-			}
-		}
-	}
-
-	// --- KNIGHTS ---
-	Bitboard knights = this->pieces(us, KNIGHT);
-	while (knights) {
-		Square from = pop_lsb(knights);
-		Bitboard targets = PseudoAttacks[KNIGHT][from] & ~our_pieces;
-		while (targets) {
-			Square to = pop_lsb(targets);
-			moves.push_back(make_move(from, to));
-		}
-	}
-
-	// --- KINGS ---
-	Bitboard king = this->pieces(us, KING); // Should be 1 bit
-	if (king) {
-		Square from = pop_lsb(king);
-		Bitboard targets = PseudoAttacks[KING][from] & ~our_pieces;
-		while (targets) {
-			Square to = pop_lsb(targets);
-			moves.push_back(make_move(from, to));
-		}
-	}
-
-	// --- SLIDING PIECES (Bishops, Rooks, Queens) ---
-	// Merging logic for efficiency
-	Bitboard sliders = this->pieces(us, BISHOP) | this->pieces(us, ROOK) | this->pieces(us, QUEEN);
-
-	while (sliders) {
-		Square from = pop_lsb(sliders);
-		PieceType pt = get_piece_type(this->piece_on(from));
-		
-		// Define directions based on piece type
-		bool orth = (pt == ROOK || pt == QUEEN);
-		bool diag = (pt == BISHOP || pt == QUEEN);
-		
-		static const int r_dirs[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
-		static const int b_dirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-
-		if (orth) {
-			for (auto& d : r_dirs) {
-				Square to = from;
-				while (true) {
-					to = advance(to, d[0], d[1]);
-					if (!is_ok(to)) break;
-					Piece target = this->piece_on(to);
-					if (target == NO_PIECE) {
-						moves.push_back(make_move(from, to));
-					} else {
-						if (get_color(target) == them) moves.push_back(make_move(from, to));
-						break; // Hit a piece (own or enemy), stop ray
-					}
-				}
-			}
-		}
-		if (diag) {
-			for (auto& d : b_dirs) {
-				Square to = from;
-				while (true) {
-					to = advance(to, d[0], d[1]);
-					if (!is_ok(to)) break;
-					Piece target = this->piece_on(to);
-					if (target == NO_PIECE) {
-						moves.push_back(make_move(from, to));
-					} else {
-						if (get_color(target) == them) moves.push_back(make_move(from, to));
-						break;
-					}
-				}
-			}
-		}
-	}
-
-	// --- CASTLING ---
-	CastlingRights cr_mask = get_side(us);
-	if (this->castling_rights() & cr_mask) {
-		if (this->can_castle(CastlingRights(cr_mask & KING_SIDE))) {
-			Square from = make_square(FILE_E, get_initial_king_rank(us));
-			Square to = make_square(FILE_G, get_initial_king_rank(us));
-			Move m = make_move(from, to);
-			m |= CASTLING;
-			moves.push_back(m);
-		}
-		if (this->can_castle(CastlingRights(cr_mask & QUEEN_SIDE))) {
-			Square from = make_square(FILE_E, get_initial_king_rank(us));
-			Square to = make_square(FILE_C, get_initial_king_rank(us));
-			Move m = make_move(from, to);
-			m |= CASTLING;
-			moves.push_back(m);
-		}
-	}
-
-	// --- FILTER LEGAL MOVES ---
-	int valid_count = 0;
-	for (int i = 0; i < moves.count; ++i) {
-		if (this->checkStrictlyLegalMove(moves[i])) {
-			moves[valid_count++] = moves[i];
-		}
-	}
-	moves.count = valid_count;
-}
-
-const std::string Position::fen() const {
-	// std::istringstream ss(fenStr);
-	// std::string piece_placement_str, castling_right_str, ep_str;
-	// char active_color;
-	// int halfmove_clock, full_move_number;
-	// ss >> piece_placement_str >> active_color >> castling_right_str >> ep_str
-	// 	>> halfmove_clock >> full_move_number;
-
-	std::ostringstream ss;
-
-	for (Rank r = RANK_8; r >= RANK_1; --r) {
-		int cons_empty = 0;
-		for (File f = FILE_A; f <= FILE_H; ++f) {
-			Square sq = make_square(f, r);
-			if (this->board[sq] == NO_PIECE) {
-				++cons_empty;
-			} else {
-				if (cons_empty > 0) {
-					ss << char(cons_empty + '0');
-					cons_empty = 0;
-				}
-				ss << piece_to_char(this->board[sq]);
-			}
-		}
-		if (cons_empty > 0) {
-			ss << char(cons_empty + '0');
-			cons_empty = 0;
-		}
-		if (r != RANK_1) ss << '/';
-	}
-
-	ss << ' ' << (this->side_to_move() == BLACK ? 'b' : 'w');
-
-	ss << ' ';
-	if (this->castling_rights() == 0) {
-		ss << '-';
-	} else {
-		if (this->castling_rights(WHITE) & KING_SIDE) ss << 'K';
-		if (this->castling_rights(WHITE) & QUEEN_SIDE) ss << 'Q';
-		if (this->castling_rights(BLACK) & KING_SIDE) ss << 'k';
-		if (this->castling_rights(BLACK) & QUEEN_SIDE) ss << 'q';
-	}
-
-	ss << ' ';
-	if (this->ep_square() == SQ_NONE) {
-		ss << '-';
-	} else {
-		ss << square_to_str(this->ep_square());
-	}
-
-	// TODO: half move clock and full move number
-	ss << " 0 1";
-	
-	return ss.str();
-}
-
-Bitboard Position::generate_attack_bitboard(Color col) const {
-	Bitboard b = 0;
-	for (Square s = SQ_A1; s < SQ_NB; ++s) {
-		Piece pc = this->board[s];
-		if (pc == NO_PIECE || col != get_color(pc)) continue;
-
-		PieceType pt = get_piece_type(pc);
-		switch (pt) {
-			case PAWN: {
-				// diagonal
-				for (int dir : { -1, 1 }) {
-					Square atk = advance(s, dir, push_pawn_rank(col));
-					if (valid_square(atk)) {
-						act_bit(b, atk);
-					}
-				}
-				// enpassant
-				Square epSquare = this->st->epSquare;
-				if (epSquare != SQ_NONE) {
-					if (get_rank(s) + push_pawn_rank(col) == get_rank(epSquare)
-					&& abs(get_file(s) - get_file(epSquare)) == 1) {
-						act_bit(b, epSquare);
-					}
-				}
-			}	break;
-
-			// simple move type
-			case KING:
-			case KNIGHT: {
-				int num_dir;
-				const int (*dirs)[2];
-				if (pt == KNIGHT) {
-					static const int knight_dirs[][2] = {
-						{1, 2},
-						{2, 1},
-						{2, -1},
-						{1, -2},
-						{-1, -2},
-						{-2, -1},
-						{-2, 1},
-						{-1, 2},
-					};
-					num_dir = 8;
-					dirs = knight_dirs;
-				} else if (pt == KING) {
-					static const int king_dirs[][2] = {
-						{0, 1}, {0, -1}, {-1, 0}, {1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
-					};
-					num_dir = 8;
-					dirs = king_dirs;
-				}
-
-				for (int i = 0; i < num_dir; ++i) {
-					Square to_square = advance(s, dirs[i][0], dirs[i][1]);
-					if (valid_square(to_square)) {
-						act_bit(b, to_square);
-					}
-				}
-			}	break;
-
-			// ray type
-			case BISHOP:
-			case ROOK:
-			case QUEEN: {
-				int num_rays;
-				const int (*rays)[2];
-
-				if (pt == BISHOP) {
-					static const int bs_rays[][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
-					num_rays = 4;
-					rays = bs_rays;
-				} else if (pt == ROOK) {
-					static const int rk_rays[][2] = { {0, 1}, {0, -1}, {-1, 0}, {1, 0} };
-					num_rays = 4;
-					rays = rk_rays;
-				} else if (pt == QUEEN) {
-					static const int qu_rays[][2] = {
-						{0, 1}, {0, -1}, {-1, 0}, {1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
-					};
-					num_rays = 8;
-					rays = qu_rays;
-				}
-
-				for (int i = 0; i < num_rays; ++i) {
-					Square to_square = advance(s, rays[i][0], rays[i][1]);
-					while (true) {
-						if (!valid_square(to_square)) break;
-						Piece pc = this->board[to_square];
-						if (pc == NO_PIECE) {
-							act_bit(b, to_square);
-						} else {
-							act_bit(b, to_square);
-							break;
-						}
-						to_square = advance(to_square, rays[i][0], rays[i][1]);
-					}
-				}
-
-			}	break;
-
-			default: assert(0);
-		}
-	}
-	return b;
-}
-
-bool Position::squareIsAttacked(Color them, Square sq) const {
-	Color us = flip_color(them);
-
-	if (PawnAttacks[us][sq] & this->pieces(them, PAWN)) return true;
-	if (PseudoAttacks[KNIGHT][sq] & this->pieces(them, KNIGHT)) return true;
-	if (PseudoAttacks[KING][sq] & this->pieces(them, KING)) return true;
-
-	// Orthogonal (Rook/Queen)
-	Bitboard themRookQueen = this->pieces(them, ROOK) | this->pieces(them, QUEEN);
-	if (themRookQueen) {
-		 const int r_dirs[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
-		 for (auto& d : r_dirs) {
-			 Square t = sq;
-			 while(true) {
-				 t = advance(t, d[0], d[1]); // Assuming advance checks boundaries and returns SQ_NB
-				 if (!valid_square(t)) break; // Stop if off board
-				 
-				 Piece p = this->board[t];
-				 if (p != NO_PIECE) {
-					 if (get_color(p) == them && (get_piece_type(p) == ROOK || get_piece_type(p) == QUEEN)) return true;
-					 break; // Hit a blocker
-				 }
-			 }
-		 }
-	}
-
-	// Diagonal (Bishop/Queen)
-	Bitboard themBishopQueen = this->pieces(them, BISHOP) | this->pieces(them, QUEEN);
-	if (themBishopQueen) {
-		 const int b_dirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-		 for (auto& d : b_dirs) {
-			 Square t = sq;
-			 while(true) {
-				 t = advance(t, d[0], d[1]);
-				 if (!valid_square(t)) break; 
-				 
-				 Piece p = this->board[t];
-				 if (p != NO_PIECE) {
-					 if (get_color(p) == them && (get_piece_type(p) == BISHOP || get_piece_type(p) == QUEEN)) return true;
-					 break; // Hit a blocker
-				 }
-			 }
-		 }
-	}
-
-	return false;
-}
-
-bool Position::pieceIsAttacked(Color c, PieceType pt) const {
-	Bitboard b = this->pieces(c, pt);
-	assert(b);
-	Square sq = lsb(b);
-	return this->squareIsAttacked(flip_color(c), sq);
-}
-
-bool Position::kingIsAttacked(Color c) const {
-	return this->pieceIsAttacked(c, KING);
-}
-
-bool Position::checkStrictlyLegalMove(Move m) {
-	StateInfo st;
-	Color us = this->sideToMove;
-	this->do_move(m, st);
-	bool legal = !this->kingIsAttacked(us);
-	this->undo_move();
-	return legal;
-}
-
-bool Position::can_move_to(Square from, Square to) {
-    Piece pc = this->board[to];
-    return pc == NO_PIECE || get_color(pc) != sideToMove;
-}
-
-bool Position::can_capture_piece(Piece pc) {
-    return pc != NO_PIECE && get_piece_type(pc) != KING;
-}
-
-Move Position::string_to_move(std::string str) {
-	assert(str.size() >= 4);
-	Square fr = str_to_square(str.substr(0, 2));
-	Square to = str_to_square(str.substr(2, 2));
-	Move m = make_move(fr, to);
-
-	if (str.size() == 5) {
-		m |= PROMOTION;
-		switch(str.back()) {
-			case 'n': m = act_promotion_type(m, KNIGHT); break;
-			case 'r': m = act_promotion_type(m, ROOK); break;
-			case 'b': m = act_promotion_type(m, BISHOP); break;
-			case 'q': m = act_promotion_type(m, QUEEN); break;
-			default: assert(0);
-		}
-	} else if (get_piece_type(this->board[fr]) == PAWN && to == this->ep_square() &&
-			abs(get_file(fr) - get_file(to)) == 1) {
-		m |= ENPASSANT;
-	} else if (get_piece_type(this->board[fr]) == KING && abs(get_file(fr) - get_file(to)) == 2) {
-		m |= CASTLING;
-	}
-	return m;
-}
-
-void Position::print_board() const {
-	for (Rank r = RANK_8; r >= RANK_1; --r) {
-		for (File f = FILE_A; f <= FILE_H; ++f) {
-			Square s = make_square(f, r);
-			if (s % 8 == 0) {
-				std::cout << std::endl;
-			}
-			if (this->board[s] == NO_PIECE) std::cout << '_';
-			else std::cout << piece_to_char(this->board[s]);
-		}
-	}
-	std::cout << std::endl;
-}
-
-
-bool Position::is_checkmate(bool checkOpponent) {
-	Color c = this->side_to_move();
-	if (checkOpponent) c = flip_color(c);
-
-	if (!this->kingIsAttacked(c)) return false;
-
-	if (c == this->side_to_move()) {
-		svec<Move> moves;
-		this->generate_moves(moves); 
-		return moves.empty(); 
-	}
-
-	return false;
-}
-
-bool Position::is_draw() const {
-	if (this->st->rule50 >= 100) return true;
-
-	int moves_to_check = this->st->rule50;
-	StateInfo* curr = this->st->prev;
-
-	for (int i = 0; i < moves_to_check && curr != nullptr; ++i) {
-		if (curr->key == this->st->key) {
-			return true; // Found repetition
-		}
-		curr = curr->prev;
-	}
-	return false;
-}
-
-bool Position::is_in_check() const {
-	return this->kingIsAttacked(this->sideToMove);
-}
-
-bool Position::can_castle(CastlingRights cr) const {
-	if (!(this->castling_rights() & cr)) return false;
-
-	Color us = this->sideToMove;
-	Color them = flip_color(us);
-
-	Square king_sq = make_square(FILE_E, get_initial_king_rank(us));
-	Square rook_sq = this->castling_rook_square(cr);
-
-	if (this->piece_on(rook_sq) != make_piece(us, ROOK))
-		return false;
-
-	Square king_to = this->castling_king_square(cr);
-	Square rook_to = this->castling_rook_to_square(cr);
-
-	if (path_bb(king_sq, rook_sq) & ~square_bb(king_sq) & ~square_bb(rook_sq) & this->pieces())
-		return false;
-
-	Bitboard king_path = path_bb(king_sq, king_to);
-	while(king_path) {
-		Square s = pop_lsb(king_path);
-		if (square_is_attacked(them, s)) return false;
-	}
-
-	if (this->piece_on(rook_to) != NO_PIECE)
-		return false;
-
-	return true;
-}
-
-void Position::do_null_move(StateInfo& newSt) {
-	// Copy state info
-	newSt.key = this->st->key;
-	newSt.castlingRights = this->st->castlingRights;
-	newSt.rule50 = this->st->rule50;
-	newSt.capturedPiece = NO_PIECE;
-	newSt.lastmove = MOVE_NULL;
-	newSt.epSquare = SQ_NONE;
-	newSt.prev = this->st;
-
-	if (this->st->epSquare != SQ_NONE) {
-		newSt.key ^= Zobrist::enpassant[get_file(this->st->epSquare)];
-	}
-
-	newSt.key ^= Zobrist::side;
-
-	newSt.rule50++; 
-
-	this->sideToMove = flip_color(this->sideToMove);
-	this->st = &newSt;
-	++this->ply;
-}
-
-void Position::undo_null_move() {
-	this->sideToMove = flip_color(this->sideToMove);
-	this->st = this->st->prev;
-	--this->ply;
-}
-
+#include "position.h"
+#include "bitboard.h"
+#include "evaluation.h"
+#include "random.h"
+#include "types.h"
+// Đã xóa bits/floatn-common.h
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+// Đã xóa unistd.h
+
+constexpr Piece Pieces[] = {	W_PAWN, W_ROOK, W_KNIGHT, W_BISHOP, W_QUEEN, W_KING,
+				B_PAWN, B_ROOK, B_KNIGHT, B_BISHOP, B_QUEEN, B_KING};
+
+namespace Zobrist {
+	Key psq[PIECE_NB][SQ_NB];
+	Key enpassant[FILE_NB];
+	Key castlingRights[CASTLING_RIGHT_NB];
+	Key side;
+	Key noPawns;
+}
+
+// Marcel van Kervinck's cuckoo tables: the keys of all reversible moves
+// of a non-pawn piece (the key difference between the positions before
+// and after the move), stored in a cuckoo hash with two hash functions.
+// There are 3668 such moves, well below the capacity of the table.
+inline int H1(Key h) { return h & 0x1fff; }
+inline int H2(Key h) { return (h >> 16) & 0x1fff; }
+
+Key cuckoo[8192];
+Move cuckooMove[8192];
+
+// Middlegame values counted in the non-pawn material
+constexpr Value NonPawnValue[PIECE_TYPE_NB] = {
+	VALUE_ZERO, VALUE_ZERO, KnightValueMg, BishopValueMg, RookValueMg, QueenValueMg, VALUE_ZERO, VALUE_ZERO
+};
+
+// Castling rights lost by a move from or to the square
+constexpr int castling_rights_mask(Square sq) {
+	switch (sq) {
+		case SQ_A1: return WHITE_OOO;
+		case SQ_H1: return WHITE_OO;
+		case SQ_E1: return WHITE_SIDE;
+		case SQ_A8: return BLACK_OOO;
+		case SQ_H8: return BLACK_OO;
+		case SQ_E8: return BLACK_SIDE;
+		default:    return NO_CASTLING_RIGHT;
+	}
+}
+
+void Position::init() {
+	for (int i = 0; i < PIECE_NB; ++i)
+		for (int j = 0; j < SQ_NB; ++j)
+			Zobrist::psq[i][j] = random_u64();
+	for (int i = 0; i < FILE_NB; ++i)
+		Zobrist::enpassant[i] = random_u64();
+	for (int i = 0; i < CASTLING_RIGHT_NB; ++i)
+		Zobrist::castlingRights[i] = random_u64();
+	Zobrist::side = random_u64();
+	Zobrist::noPawns = random_u64();
+
+	std::memset(cuckoo, 0, sizeof(cuckoo));
+	std::memset(cuckooMove, 0, sizeof(cuckooMove));
+	int count = 0;
+	for (Piece pc : Pieces) {
+		if (get_piece_type(pc) == PAWN) continue;
+		for (int s1 = 0; s1 < SQ_NB; ++s1) {
+			for (int s2 = s1 + 1; s2 < SQ_NB; ++s2) {
+				if (!(PseudoAttacks[get_piece_type(pc)][s1] & square_bb(Square(s2)))) continue;
+
+				Move move = make_move(Square(s1), Square(s2));
+				Key key = Zobrist::psq[pc][s1] ^ Zobrist::psq[pc][s2] ^ Zobrist::side;
+				int i = H1(key);
+				while (true) {
+					std::swap(cuckoo[i], key);
+					std::swap(cuckooMove[i], move);
+					if (move == MOVE_NONE) break; // arrived at an empty slot
+					i = (i == H1(key)) ? H2(key) : H1(key); // push the victim to its other slot
+				}
+				++count;
+			}
+		}
+	}
+	assert(count == 3668);
+	(void)count;
+}
+
+void Position::set(std::string fenStr, StateInfo& st) {
+	std::istringstream ss(fenStr);
+	std::string piece_placement_str, castling_right_str, ep_str;
+	char active_color;
+	int halfmove_clock = 0, full_move_number = 1;
+	ss >> piece_placement_str >> active_color >> castling_right_str >> ep_str
+		>> halfmove_clock >> full_move_number;
+
+	// Piece board[SQ_NB];
+	// Bitboard byColorBB[COLOR_NB];
+	// Bitboard byTypeBB[PIECE_TYPE_NB];
+	// Color sideToMove;
+	// int ply;
+	// StateInfo *st;
+
+	// struct StateInfo {
+	// 	Key key;
+	// 	int castlingRights;
+	// 	int rule50;
+	// 	Piece capturedPiece;
+	// 	Move lastmove;
+	// 	Square epSquare;
+	// 	StateInfo *prev;
+	// };
+
+	this->clear(st);
+	st.rule50 = halfmove_clock;
+	// st.epSquare = (ep_str == "-") ? SQ_NONE : str_to_square(ep_str);
+
+	Square current_sq = SQ_A8;
+	for (char c : piece_placement_str) {
+		if ('0' <= c && c <= '9') {
+			current_sq += int(c - '0');
+		} else if (c == '/') {
+			current_sq -= 16;
+		} else {
+			this->put_piece(char_to_piece(c), current_sq);
+			++current_sq;
+		}
+	}
+	assert(current_sq == SQ_A1 + 8);
+
+	this->sideToMove = (active_color == 'b') ? BLACK : WHITE;
+
+	// convert the full move number to a game ply counted from the start
+	this->ply = std::max(2 * (full_move_number - 1), 0) + (this->sideToMove == BLACK);
+
+	for (char c : castling_right_str) {
+		st.castlingRights |= char_to_castling_rights(c);
+	}
+	st.epSquare = (ep_str == "-") ? SQ_NONE : str_to_square(ep_str);
+
+	this->set_keys();
+}
+
+void Position::set(const PackedPosition& pp, StateInfo& st) {
+	this->clear(st);
+
+	int i = 0;
+	for (Bitboard b = pp.occupied; b; ++i) {
+		Square sq = pop_lsb(b);
+		this->put_piece(Piece((pp.pieces[i / 2] >> (4 * (i & 1))) & 0xF), sq);
+	}
+
+	this->sideToMove = Color(pp.sideToMove);
+	this->ply = std::max(2 * (pp.fullmoveNumber - 1), 0) + (this->sideToMove == BLACK);
+	st.castlingRights = pp.castlingRights;
+	st.epSquare = Square(pp.epSquare);
+	st.rule50 = pp.rule50;
+
+	this->set_keys();
+}
+
+PackedPosition Position::pack() const {
+	PackedPosition pp = {};
+	pp.occupied = this->pieces();
+	assert(__builtin_popcountll(pp.occupied) <= 32);
+
+	int i = 0;
+	for (Bitboard b = pp.occupied; b; ++i) {
+		Square sq = pop_lsb(b);
+		pp.pieces[i / 2] |= uint8_t(this->board[sq] << (4 * (i & 1)));
+	}
+
+	pp.sideToMove = uint8_t(this->sideToMove);
+	pp.castlingRights = uint8_t(this->st->castlingRights);
+	pp.epSquare = uint8_t(this->st->epSquare);
+	pp.rule50 = uint8_t(std::min(this->st->rule50, 255));
+	pp.fullmoveNumber = uint16_t(1 + this->ply / 2);
+	return pp;
+}
+
+void Position::clear(StateInfo& st) {
+	// init position
+	assert(NO_PIECE == 0);
+	memset(this->board, NO_PIECE, sizeof(this->board));
+	memset(this->byColorBB, 0, sizeof(this->byColorBB));
+	memset(this->byTypeBB, 0, sizeof(this->byTypeBB));
+	this->psqScore = SCORE_ZERO;
+	memset(this->pieceCount, 0, sizeof(this->pieceCount));
+	this->nonPawnMaterial[WHITE] = this->nonPawnMaterial[BLACK] = VALUE_ZERO;
+	this->st = &st;
+
+	// init state info
+	st.dirtyPiece.dirty_num = 0;
+	st.accumulator.computed[WHITE] = st.accumulator.computed[BLACK] = false;
+	st.castlingRights = 0;
+	st.rule50 = 0;
+	st.capturedPiece = NO_PIECE;
+	st.lastmove = MOVE_NONE;
+	st.pliesFromNull = 0;
+	st.prev = nullptr;
+}
+
+void Position::set_keys() {
+	st->key = 0;
+	st->pawnKey = Zobrist::noPawns;
+	st->materialKey = 0;
+
+	for (Bitboard b = this->pieces(); b; ) {
+		Square sq = pop_lsb(b);
+		Piece pc = this->board[sq];
+		st->key ^= Zobrist::psq[pc][sq];
+		if (get_piece_type(pc) == PAWN) st->pawnKey ^= Zobrist::psq[pc][sq];
+	}
+
+	// The material key has one Zobrist key per piece, indexed by its count
+	for (Piece pc : Pieces) {
+		for (int cnt = 0; cnt < this->pieceCount[pc]; ++cnt) {
+			st->materialKey ^= Zobrist::psq[pc][cnt];
+		}
+	}
+
+	if (this->sideToMove == BLACK) {
+		st->key ^= Zobrist::side;
+	}
+	st->key ^= Zobrist::castlingRights[st->castlingRights];
+	if (st->epSquare != SQ_NONE) {
+		st->key ^= Zobrist::enpassant[get_file(st->epSquare)];
+	}
+}
+
+void Position::put_piece(Piece pc, Square sq) {
+	if (pc == NO_PIECE) return;
+	this->board[sq] = pc;
+	act_bit(this->byColorBB[get_color(pc)], sq);
+	act_bit(this->byTypeBB[get_piece_type(pc)], sq);
+
+	Color c = get_color(pc);
+	this->psqScore += (c == WHITE) ? PSQT::psq[pc][sq] : -PSQT::psq[pc][sq];
+	this->nonPawnMaterial[c] += NonPawnValue[get_piece_type(pc)];
+	++this->pieceCount[pc];
+}
+
+void Position::remove_piece(Square sq) {
+	Piece pc = this->board[sq];
+	if (pc == NO_PIECE) return;
+	this->board[sq] = NO_PIECE;
+	dec_bit(this->byColorBB[get_color(pc)], sq);
+	dec_bit(this->byTypeBB[get_piece_type(pc)], sq);
+
+	Color c = get_color(pc);
+	this->psqScore -= (c == WHITE) ? PSQT::psq[pc][sq] : -PSQT::psq[pc][sq];
+	this->nonPawnMaterial[c] -= NonPawnValue[get_piece_type(pc)];
+	--this->pieceCount[pc];
+}
+
+void Position::move_piece(Square fr, Square to) {
+	assert (fr != to);
+	Piece pc = this->board[fr];
+	this->remove_piece(fr);
+	this->remove_piece(to);
+	this->put_piece(pc, to);
+}
+
+void Position::do_move(Move m, StateInfo& newSt) {
+	// Piece board[SQ_NB];
+	// Bitboard byColorBB[COLOR_NB];
+	// Bitboard byTypeBB[PIECE_TYPE_NB];
+	// Color sideToMove;
+	// int ply;
+	// StateInfo *st;
+
+	// 	Key key;
+	// 	int castlingRights;
+	// 	int rule50;
+	// 	Piece capturedPiece;
+	// 	Move lastmove;
+	// 	Square epSquare;
+	// 	StateInfo *prev;
+
+	newSt.key = this->st->key;
+	newSt.pawnKey = this->st->pawnKey;
+	newSt.materialKey = this->st->materialKey;
+	newSt.castlingRights = this->st->castlingRights;
+	newSt.rule50 = this->st->rule50;
+	newSt.capturedPiece = NO_PIECE;
+	newSt.lastmove = m;
+	newSt.epSquare = SQ_NONE;
+	newSt.pliesFromNull = this->st->pliesFromNull + 1;
+	newSt.prev = this->st;
+	newSt.accumulator.computed[WHITE] = newSt.accumulator.computed[BLACK] = false;
+
+	Square fr_square = from_sq(m);
+	Square to_square = to_sq(m);
+	Piece fr_piece = this->board[fr_square];
+	Piece to_piece = this->board[to_square];
+	PieceType fr_piece_type = get_piece_type(fr_piece);
+
+	// undo key
+	if (fr_piece != NO_PIECE) {
+		newSt.key ^= Zobrist::psq[fr_piece][fr_square];
+	}
+	if (to_piece != NO_PIECE) {
+		newSt.key ^= Zobrist::psq[to_piece][to_square];
+		newSt.capturedPiece = to_piece;
+		if (get_piece_type(to_piece) == PAWN) newSt.pawnKey ^= Zobrist::psq[to_piece][to_square];
+	}
+	if (fr_piece_type == PAWN) {
+		newSt.pawnKey ^= Zobrist::psq[fr_piece][fr_square];
+		if (type_of(m) != PROMOTION) newSt.pawnKey ^= Zobrist::psq[fr_piece][to_square];
+	}
+	if (this->st->epSquare != SQ_NONE) {
+		newSt.key ^= Zobrist::enpassant[get_file(this->st->epSquare)];
+	}
+	newSt.key ^= Zobrist::castlingRights[this->st->castlingRights];
+
+	// the final key update only handle from and to square hash, additional
+	// changes handled for each type
+	MoveType moveType = type_of(m);
+
+	// The moving piece, then the captured piece or the castling rook
+	DirtyPiece& dp = newSt.dirtyPiece;
+	dp.dirty_num = 1;
+	dp.piece[0] = fr_piece;
+	dp.from[0] = fr_square;
+	dp.to[0] = to_square;
+	if (to_piece != NO_PIECE) {
+		dp.dirty_num = 2;
+		dp.piece[1] = to_piece;
+		dp.from[1] = to_square;
+		dp.to[1] = SQ_NONE;
+	}
+
+	switch (moveType) {
+		case PROMOTION: {
+			Piece pro_piece = make_piece(this->sideToMove, promotion_type(m));
+			this->remove_piece(fr_square);
+			this->remove_piece(to_square);
+			this->put_piece(pro_piece, to_square);
+
+			dp.to[0] = SQ_NONE;
+			dp.piece[dp.dirty_num] = pro_piece;
+			dp.from[dp.dirty_num] = SQ_NONE;
+			dp.to[dp.dirty_num] = to_square;
+			++dp.dirty_num;
+		}	break;
+		case ENPASSANT: {
+			this->move_piece(fr_square, to_square);
+			Square eaten_pawn_sq = fr_square + Direction(get_file(to_square) - get_file(fr_square));
+			Piece eaten_pawn_pc = this->board[eaten_pawn_sq];
+			newSt.key ^= Zobrist::psq[eaten_pawn_pc][eaten_pawn_sq];
+			newSt.pawnKey ^= Zobrist::psq[eaten_pawn_pc][eaten_pawn_sq];
+			this->remove_piece(eaten_pawn_sq);
+
+			newSt.capturedPiece = eaten_pawn_pc;
+			dp.dirty_num = 2;
+			dp.piece[1] = eaten_pawn_pc;
+			dp.from[1] = eaten_pawn_sq;
+			dp.to[1] = SQ_NONE;
+		}	break;
+		case CASTLING: {
+			Square rook_from, rook_to;
+			Rank rook_rank = get_initial_king_rank(this->sideToMove);
+			if (get_file(to_square) == FILE_C) { // queen side
+				rook_from = make_square(FILE_A, rook_rank);
+				rook_to = make_square(FILE_D, rook_rank);
+			} else {
+				rook_from = make_square(FILE_H, rook_rank);
+				rook_to = make_square(FILE_F, rook_rank);
+			}
+			Piece rook_pc = make_piece(this->sideToMove, ROOK);
+			newSt.key ^= Zobrist::psq[rook_pc][rook_from];
+			this->move_piece(rook_from, rook_to);
+			newSt.key ^= Zobrist::psq[rook_pc][rook_to];
+
+			dp.dirty_num = 2;
+			dp.piece[1] = rook_pc;
+			dp.from[1] = rook_from;
+			dp.to[1] = rook_to;
+
+			this->move_piece(fr_square, to_square);
+		}	break;
+		default:
+			this->move_piece(fr_square, to_square);
+			// check if this move is the pawn move up two step and set newSt.epSquare
+			if (fr_piece_type == PAWN
+			&& abs(get_rank(fr_square) - get_rank(to_square)) == 2) {
+				newSt.epSquare = to_square - push_pawn(this->sideToMove);
+			}
+			break;
+	}
+
+	// Moving the king or a rook, or capturing a rook, loses castling rights
+	newSt.castlingRights &= ~(castling_rights_mask(fr_square) | castling_rights_mask(to_square));
+
+	// Material key: the piece counts are already updated
+	if (newSt.capturedPiece != NO_PIECE) {
+		newSt.materialKey ^= Zobrist::psq[newSt.capturedPiece][this->pieceCount[newSt.capturedPiece]];
+	}
+	if (moveType == PROMOTION) {
+		Piece pro_piece = make_piece(this->sideToMove, promotion_type(m));
+		newSt.materialKey ^= Zobrist::psq[pro_piece][this->pieceCount[pro_piece] - 1]
+		                   ^ Zobrist::psq[fr_piece][this->pieceCount[fr_piece]];
+	}
+
+	if (fr_piece_type == PAWN || newSt.capturedPiece != NO_PIECE) {
+		newSt.rule50 = 0;
+	} else {
+		++newSt.rule50;
+	}
+
+	// update new key
+	Piece piece_to_add = fr_piece;
+	if (moveType == PROMOTION) {
+		piece_to_add = make_piece(this->sideToMove, promotion_type(m));
+	}
+	newSt.key ^= Zobrist::psq[piece_to_add][to_square];
+
+	if (newSt.epSquare != SQ_NONE) {
+		newSt.key ^= Zobrist::enpassant[get_file(newSt.epSquare)];
+	}
+	newSt.key ^= Zobrist::castlingRights[newSt.castlingRights];
+
+	// flip side
+	this->sideToMove = flip_color(this->sideToMove);
+	newSt.key ^= Zobrist::side;
+
+	this->st = &newSt;
+	++this->ply;
+}
+
+void Position::undo_move() {
+	Piece capturedPiece = this->st->capturedPiece;
+	int cr = this->st->castlingRights;
+	Square epSquare = this->st->epSquare;
+	Move lastmove = this->st->lastmove;
+	MoveType movetype = type_of(lastmove);
+
+	Color movingSide = flip_color(this->sideToMove);
+
+	Square fr_square = from_sq(lastmove);
+	Square to_square = to_sq(lastmove);
+	Piece fr_piece = movetype == PROMOTION ? make_piece(movingSide, PAWN) : this->board[to_square];
+	Piece to_piece = movetype == ENPASSANT ? NO_PIECE : capturedPiece;
+	// PieceType fr_piece_type = get_piece_type(fr_piece);
+
+	this->remove_piece(fr_square);
+	this->remove_piece(to_square);
+	this->put_piece(fr_piece, fr_square);
+	this->put_piece(to_piece, to_square);
+
+	if (movetype == CASTLING) {
+		Square rook_from, rook_to;
+		Rank rook_rank = get_initial_king_rank(movingSide);
+		if (get_file(to_square) == FILE_C) { // queen side
+			rook_from = make_square(FILE_A, rook_rank);
+			rook_to = make_square(FILE_D, rook_rank);
+		} else {
+			rook_from = make_square(FILE_H, rook_rank);
+			rook_to = make_square(FILE_F, rook_rank);
+		}
+		this->remove_piece(rook_to);
+		this->put_piece(make_piece(movingSide, ROOK), rook_from);
+	} else if (movetype == ENPASSANT) {
+		Square eaten_pawn_sq = fr_square + Direction(get_file(to_square) - get_file(fr_square));
+		Piece eaten_pawn_pc = make_piece(flip_color(movingSide), PAWN);
+		this->put_piece(eaten_pawn_pc, eaten_pawn_sq);
+	}
+
+	this->sideToMove = movingSide;
+	this->st = this->st->prev;
+	--this->ply;
+}
+
+void Position::generate_moves(svec<Move>& moves) {
+	moves.clear();
+
+	Color us = this->sideToMove;
+	Color them = flip_color(us);
+
+	Bitboard our_pieces = this->pieces(us);
+	Bitboard their_pieces = this->pieces(them);
+	Bitboard empty_squares = ~(our_pieces | their_pieces);
+
+	// --- PAWNS ---
+	Bitboard pawns = this->pieces(us, PAWN);
+	Direction up = push_pawn(us);
+	Rank promo_rank = get_initial_pawn_rank(them);
+	Rank start_rank = get_initial_pawn_rank(us);
+
+	// 1. Single Push
+	// Shift pawns 'up'. AND with empty squares.
+	Bitboard single_push = (us == WHITE ? (pawns << 8) : (pawns >> 8)) & empty_squares;
+
+	Bitboard b = single_push;
+	while (b) {
+		Square to = pop_lsb(b);
+		Square from = to - up;
+		
+		if (get_rank(from) == promo_rank) {
+			Move m = make_move(from, to);
+			m |= PROMOTION;
+			moves.push_back(act_promotion_type(m, QUEEN));
+			moves.push_back(act_promotion_type(m, ROOK));
+			moves.push_back(act_promotion_type(m, BISHOP));
+			moves.push_back(act_promotion_type(m, KNIGHT));
+		} else {
+			moves.push_back(make_move(from, to));
+		}
+	}
+
+	// 2. Double Push
+	// Shift single_push 'up' again. AND with empty squares. AND check rank.
+	// White: Rank 3 -> 4. Black: Rank 6 -> 5.
+	Bitboard double_push = (us == WHITE ? (single_push << 8) : (single_push >> 8)) & empty_squares;
+	// Mask specific ranks (Rank 4 for White, Rank 5 for Black)
+	double_push &= (us == WHITE ? 0x00000000FF000000ULL : 0x000000FF00000000ULL);
+
+	b = double_push;
+	while (b) {
+		Square to = pop_lsb(b);
+		moves.push_back(make_move(to - up - up, to));
+	}
+
+	// 3. Captures
+	// Left Capture
+	Bitboard captures = 0;
+	// Note: Simple shift logic, requires file masking to prevent wrapping A-file to H-file
+	if (us == WHITE) captures = ((pawns & ~FileMask[FILE_A]) << 7) & their_pieces;
+	else             captures = ((pawns & ~FileMask[FILE_A]) >> 9) & their_pieces;
+
+	b = captures;
+	while (b) {
+		Square to = pop_lsb(b);
+		// From square calculation depends on direction
+		Square from = (us == WHITE) ? (to - 7) : (to + 9);
+		
+		if (get_rank(from) == promo_rank) {
+			Move m = Move(make_move(from, to) | PROMOTION);
+			moves.push_back(act_promotion_type(m, QUEEN));
+			moves.push_back(act_promotion_type(m, ROOK));
+			moves.push_back(act_promotion_type(m, BISHOP));
+			moves.push_back(act_promotion_type(m, KNIGHT));
+		} else {
+			moves.push_back(make_move(from, to));
+		}
+	}
+
+	// Right Capture
+	if (us == WHITE) captures = ((pawns & ~FileMask[FILE_H]) << 9) & their_pieces;
+	else             captures = ((pawns & ~FileMask[FILE_H]) >> 7) & their_pieces;
+
+	b = captures;
+	while (b) {
+		Square to = pop_lsb(b);
+		Square from = (us == WHITE) ? (to - 9) : (to + 7);
+		
+		if (get_rank(from) == promo_rank) {
+			Move m = Move(make_move(from, to) | PROMOTION);
+			moves.push_back(act_promotion_type(m, QUEEN));
+			moves.push_back(act_promotion_type(m, ROOK));
+			moves.push_back(act_promotion_type(m, BISHOP));
+			moves.push_back(act_promotion_type(m, KNIGHT));
+		} else {
+			moves.push_back(make_move(from, to));
+		}
+	}
+
+	// 4. En Passant
+	if (this->st->epSquare != SQ_NONE) {
+		Square ep = this->st->epSquare;
+		// Check pawns that can capture EP (left and right of EP square)
+		// This effectively checks "pawns attacking epSquare" logic reversed
+		Bitboard attackers = this->pieces(us, PAWN);
+		// Check pawn to the "left" (file - 1)
+		if (get_file(ep) > FILE_A) {
+			Square from = ep - up - 1; // e.g., if ep is d3, from is c3 (white) or c4? 
+			// Better: Check if we have a pawn at [ep_file-1, current_rank]
+			Square l_pawn = make_square(File(get_file(ep)-1), Rank(get_rank(ep)-push_pawn_rank(us)));
+			if (this->piece_on(l_pawn) == make_piece(us, PAWN)) {
+				 Move m = make_move(l_pawn, ep);
+				 m |= ENPASSANT;
+				 moves.push_back(m);
+			}
+		}
+		if (get_file(ep) < FILE_H) {
+			Square r_pawn = make_square(File(get_file(ep)+1), Rank(get_rank(ep)-push_pawn_rank(us)));
+			if (this->piece_on(r_pawn) == make_piece(us, PAWN)) {
+				 Move m = make_move(r_pawn, ep);
+				 m |= ENPASSANT;
+				 moves.push_back(m);
+			}
+		}
+	}
+
+	// --- KNIGHTS ---
+	Bitboard knights = this->pieces(us, KNIGHT);
+	while (knights) {
+		Square from = pop_lsb(knights);
+		Bitboard targets = PseudoAttacks[KNIGHT][from] & ~our_pieces;
+		while (targets) {
+			Square to = pop_lsb(targets);
+			moves.push_back(make_move(from, to));
+		}
+	}
+
+	// --- KINGS ---
+	Bitboard king = this->pieces(us, KING); // Should be 1 bit
+	if (king) {
+		Square from = pop_lsb(king);
+		Bitboard targets = PseudoAttacks[KING][from] & ~our_pieces;
+		while (targets) {
+			Square to = pop_lsb(targets);
+			moves.push_back(make_move(from, to));
+		}
+	}
+
+	// --- SLIDING PIECES (Bishops, Rooks, Queens) ---
+	// Merging logic for efficiency
+	Bitboard sliders = this->pieces(us, BISHOP) | this->pieces(us, ROOK) | this->pieces(us, QUEEN);
+
+	while (sliders) {
+		Square from = pop_lsb(sliders);
+		PieceType pt = get_piece_type(this->piece_on(from));
+		
+		// Define directions based on piece type
+		bool orth = (pt == ROOK || pt == QUEEN);
+		bool diag = (pt == BISHOP || pt == QUEEN);
+		
+		static const int r_dirs[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
+		static const int b_dirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+
+		if (orth) {
+			for (auto& d : r_dirs) {
+				Square to = from;
+				while (true) {
+					to = advance(to, d[0], d[1]);
+					if (!is_ok(to)) break;
+					Piece target = this->piece_on(to);
+					if (target == NO_PIECE) {
+						moves.push_back(make_move(from, to));
+					} else {
+						if (get_color(target) == them) moves.push_back(make_move(from, to));
+						break; // Hit a piece (own or enemy), stop ray
+					}
+				}
+			}
+		}
+		if (diag) {
+			for (auto& d : b_dirs) {
+				Square to = from;
+				while (true) {
+					to = advance(to, d[0], d[1]);
+					if (!is_ok(to)) break;
+					Piece target = this->piece_on(to);
+					if (target == NO_PIECE) {
+						moves.push_back(make_move(from, to));
+					} else {
+						if (get_color(target) == them) moves.push_back(make_move(from, to));
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// --- CASTLING ---
+	CastlingRights cr_mask = get_side(us);
+	if (this->castling_rights() & cr_mask) {
+		if (this->can_castle(CastlingRights(cr_mask & KING_SIDE))) {
+			Square from = make_square(FILE_E, get_initial_king_rank(us));
+			Square to = make_square(FILE_G, get_initial_king_rank(us));
+			Move m = make_move(from, to);
+			m |= CASTLING;
+			moves.push_back(m);
+		}
+		if (this->can_castle(CastlingRights(cr_mask & QUEEN_SIDE))) {
+			Square from = make_square(FILE_E, get_initial_king_rank(us));
+			Square to = make_square(FILE_C, get_initial_king_rank(us));
+			Move m = make_move(from, to);
+			m |= CASTLING;
+			moves.push_back(m);
+		}
+	}
+
+	// --- FILTER LEGAL MOVES ---
+	int valid_count = 0;
+	for (int i = 0; i < moves.count; ++i) {
+		if (this->checkStrictlyLegalMove(moves[i])) {
+			moves[valid_count++] = moves[i];
+		}
+	}
+	moves.count = valid_count;
+}
+
+const std::string Position::fen() const {
+	// std::istringstream ss(fenStr);
+	// std::string piece_placement_str, castling_right_str, ep_str;
+	// char active_color;
+	// int halfmove_clock, full_move_number;
+	// ss >> piece_placement_str >> active_color >> castling_right_str >> ep_str
+	// 	>> halfmove_clock >> full_move_number;
+
+	std::ostringstream ss;
+
+	for (Rank r = RANK_8; r >= RANK_1; --r) {
+		int cons_empty = 0;
+		for (File f = FILE_A; f <= FILE_H; ++f) {
+			Square sq = make_square(f, r);
+			if (this->board[sq] == NO_PIECE) {
+				++cons_empty;
+			} else {
+				if (cons_empty > 0) {
+					ss << char(cons_empty + '0');
+					cons_empty = 0;
+				}
+				ss << piece_to_char(this->board[sq]);
+			}
+		}
+		if (cons_empty > 0) {
+			ss << char(cons_empty + '0');
+			cons_empty = 0;
+		}
+		if (r != RANK_1) ss << '/';
+	}
+
+	ss << ' ' << (this->side_to_move() == BLACK ? 'b' : 'w');
+
+	ss << ' ';
+	if (this->castling_rights() == 0) {
+		ss << '-';
+	} else {
+		if (this->castling_rights(WHITE) & KING_SIDE) ss << 'K';
+		if (this->castling_rights(WHITE) & QUEEN_SIDE) ss << 'Q';
+		if (this->castling_rights(BLACK) & KING_SIDE) ss << 'k';
+		if (this->castling_rights(BLACK) & QUEEN_SIDE) ss << 'q';
+	}
+
+	ss << ' ';
+	if (this->ep_square() == SQ_NONE) {
+		ss << '-';
+	} else {
+		ss << square_to_str(this->ep_square());
+	}
+
+	// TODO: half move clock and full move number
+	ss << " 0 1";
+	
+	return ss.str();
+}
+
+Bitboard Position::generate_attack_bitboard(Color col) const {
+	Bitboard b = 0;
+	for (Square s = SQ_A1; s < SQ_NB; ++s) {
+		Piece pc = this->board[s];
+		if (pc == NO_PIECE || col != get_color(pc)) continue;
+
+		PieceType pt = get_piece_type(pc);
+		switch (pt) {
+			case PAWN: {
+				// diagonal
+				for (int dir : { -1, 1 }) {
+					Square atk = advance(s, dir, push_pawn_rank(col));
+					if (valid_square(atk)) {
+						act_bit(b, atk);
+					}
+				}
+				// enpassant
+				Square epSquare = this->st->epSquare;
+				if (epSquare != SQ_NONE) {
+					if (get_rank(s) + push_pawn_rank(col) == get_rank(epSquare)
+					&& abs(get_file(s) - get_file(epSquare)) == 1) {
+						act_bit(b, epSquare);
+					}
+				}
+			}	break;
+
+			// simple move type
+			case KING:
+			case KNIGHT: {
+				int num_dir;
+				const int (*dirs)[2];
+				if (pt == KNIGHT) {
+					static const int knight_dirs[][2] = {
+						{1, 2},
+						{2, 1},
+						{2, -1},
+						{1, -2},
+						{-1, -2},
+						{-2, -1},
+						{-2, 1},
+						{-1, 2},
+					};
+					num_dir = 8;
+					dirs = knight_dirs;
+				} else if (pt == KING) {
+					static const int king_dirs[][2] = {
+						{0, 1}, {0, -1}, {-1, 0}, {1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
+					};
+					num_dir = 8;
+					dirs = king_dirs;
+				}
+
+				for (int i = 0; i < num_dir; ++i) {
+					Square to_square = advance(s, dirs[i][0], dirs[i][1]);
+					if (valid_square(to_square)) {
+						act_bit(b, to_square);
+					}
+				}
+			}	break;
+
+			// ray type
+			case BISHOP:
+			case ROOK:
+			case QUEEN: {
+				int num_rays;
+				const int (*rays)[2];
+
+				if (pt == BISHOP) {
+					static const int bs_rays[][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+					num_rays = 4;
+					rays = bs_rays;
+				} else if (pt == ROOK) {
+					static const int rk_rays[][2] = { {0, 1}, {0, -1}, {-1, 0}, {1, 0} };
+					num_rays = 4;
+					rays = rk_rays;
+				} else if (pt == QUEEN) {
+					static const int qu_rays[][2] = {
+						{0, 1}, {0, -1}, {-1, 0}, {1, 0}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
+					};
+					num_rays = 8;
+					rays = qu_rays;
+				}
+
+				for (int i = 0; i < num_rays; ++i) {
+					Square to_square = advance(s, rays[i][0], rays[i][1]);
+					while (true) {
+						if (!valid_square(to_square)) break;
+						Piece pc = this->board[to_square];
+						if (pc == NO_PIECE) {
+							act_bit(b, to_square);
+						} else {
+							act_bit(b, to_square);
+							break;
+						}
+						to_square = advance(to_square, rays[i][0], rays[i][1]);
+					}
+				}
+
+			}	break;
+
+			default: assert(0);
+		}
+	}
+	return b;
+}
+
+bool Position::squareIsAttacked(Color them, Square sq) const {
+	Color us = flip_color(them);
+
+	if (PawnAttacks[us][sq] & this->pieces(them, PAWN)) return true;
+	if (PseudoAttacks[KNIGHT][sq] & this->pieces(them, KNIGHT)) return true;
+	if (PseudoAttacks[KING][sq] & this->pieces(them, KING)) return true;
+
+	// Orthogonal (Rook/Queen)
+	Bitboard themRookQueen = this->pieces(them, ROOK) | this->pieces(them, QUEEN);
+	if (themRookQueen) {
+		 const int r_dirs[4][2] = {{0,1},{0,-1},{1,0},{-1,0}};
+		 for (auto& d : r_dirs) {
+			 Square t = sq;
+			 while(true) {
+				 t = advance(t, d[0], d[1]); // Assuming advance checks boundaries and returns SQ_NB
+				 if (!valid_square(t)) break; // Stop if off board
+				 
+				 Piece p = this->board[t];
+				 if (p != NO_PIECE) {
+					 if (get_color(p) == them && (get_piece_type(p) == ROOK || get_piece_type(p) == QUEEN)) return true;
+					 break; // Hit a blocker
+				 }
+			 }
+		 }
+	}
+
+	// Diagonal (Bishop/Queen)
+	Bitboard themBishopQueen = this->pieces(them, BISHOP) | this->pieces(them, QUEEN);
+	if (themBishopQueen) {
+		 const int b_dirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+		 for (auto& d : b_dirs) {
+			 Square t = sq;
+			 while(true) {
+				 t = advance(t, d[0], d[1]);
+				 if (!valid_square(t)) break; 
+				 
+				 Piece p = this->board[t];
+				 if (p != NO_PIECE) {
+					 if (get_color(p) == them && (get_piece_type(p) == BISHOP || get_piece_type(p) == QUEEN)) return true;
+					 break; // Hit a blocker
+				 }
+			 }
+		 }
+	}
+
+	return false;
+}
+
+bool Position::pieceIsAttacked(Color c, PieceType pt) const {
+	Bitboard b = this->pieces(c, pt);
+	assert(b);
+	Square sq = lsb(b);
+	return this->squareIsAttacked(flip_color(c), sq);
+}
+
+bool Position::kingIsAttacked(Color c) const {
+	return this->pieceIsAttacked(c, KING);
+}
+
+bool Position::checkStrictlyLegalMove(Move m) {
+	StateInfo st;
+	Color us = this->sideToMove;
+	this->do_move(m, st);
+	bool legal = !this->kingIsAttacked(us);
+	this->undo_move();
+	return legal;
+}
+
+bool Position::can_move_to(Square from, Square to) {
+    Piece pc = this->board[to];
+    return pc == NO_PIECE || get_color(pc) != sideToMove;
+}
+
+bool Position::can_capture_piece(Piece pc) {
+    return pc != NO_PIECE && get_piece_type(pc) != KING;
+}
+
+Move Position::string_to_move(std::string str) {
+	assert(str.size() >= 4);
+	Square fr = str_to_square(str.substr(0, 2));
+	Square to = str_to_square(str.substr(2, 2));
+	Move m = make_move(fr, to);
+
+	if (str.size() == 5) {
+		m |= PROMOTION;
+		switch(str.back()) {
+			case 'n': m = act_promotion_type(m, KNIGHT); break;
+			case 'r': m = act_promotion_type(m, ROOK); break;
+			case 'b': m = act_promotion_type(m, BISHOP); break;
+			case 'q': m = act_promotion_type(m, QUEEN); break;
+			default: assert(0);
+		}
+	} else if (get_piece_type(this->board[fr]) == PAWN && to == this->ep_square() &&
+			abs(get_file(fr) - get_file(to)) == 1) {
+		m |= ENPASSANT;
+	} else if (get_piece_type(this->board[fr]) == KING && abs(get_file(fr) - get_file(to)) == 2) {
+		m |= CASTLING;
+	}
+	return m;
+}
+
+void Position::print_board() const {
+	for (Rank r = RANK_8; r >= RANK_1; --r) {
+		for (File f = FILE_A; f <= FILE_H; ++f) {
+			Square s = make_square(f, r);
+			if (s % 8 == 0) {
+				std::cout << std::endl;
+			}
+			if (this->board[s] == NO_PIECE) std::cout << '_';
+			else std::cout << piece_to_char(this->board[s]);
+		}
+	}
+	std::cout << std::endl;
+}
+
+
+bool Position::is_checkmate(bool checkOpponent) {
+	Color c = this->side_to_move();
+	if (checkOpponent) c = flip_color(c);
+
+	if (!this->kingIsAttacked(c)) return false;
+
+	if (c == this->side_to_move()) {
+		svec<Move> moves;
+		this->generate_moves(moves); 
+		return moves.empty(); 
+	}
+
+	return false;
+}
+
+bool Position::is_draw() const {
+	if (this->st->rule50 >= 100) return true;
+
+	// A repetition needs the same side to move, at least 4 plies back and
+	// after the last irreversible move or null move
+	int end = std::min(this->st->rule50, this->st->pliesFromNull);
+	if (end < 4) return false;
+
+	StateInfo* stp = this->st->prev->prev;
+	for (int i = 4; i <= end; i += 2) {
+		stp = stp->prev->prev;
+		if (stp->key == this->st->key) {
+			return true; // Found repetition
+		}
+	}
+	return false;
+}
+
+bool Position::has_game_cycle(int ply) const {
+	int end = std::min(this->st->rule50, this->st->pliesFromNull);
+	if (end < 3) return false;
+
+	Key originalKey = this->st->key;
+	StateInfo* stp = this->st->prev;
+
+	for (int i = 3; i <= end; i += 2) {
+		stp = stp->prev->prev;
+
+		// The key difference is the key of a single reversible move
+		Key moveKey = originalKey ^ stp->key;
+		int j;
+		if ((j = H1(moveKey), cuckoo[j] == moveKey)
+		 || (j = H2(moveKey), cuckoo[j] == moveKey)) {
+			Move move = cuckooMove[j];
+			Square s1 = from_sq(move);
+			Square s2 = to_sq(move);
+
+			// The move is only possible if its path is free. Cycles through
+			// positions before the root are left to is_draw().
+			if (!(BetweenBB[s1][s2] & this->pieces()) && ply > i) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool Position::is_in_check() const {
+	return this->kingIsAttacked(this->sideToMove);
+}
+
+Bitboard Position::attackers_to(Square sq, Bitboard occupied) const {
+	return (PawnAttacks[BLACK][sq] & this->pieces(WHITE, PAWN))
+	     | (PawnAttacks[WHITE][sq] & this->pieces(BLACK, PAWN))
+	     | (PseudoAttacks[KNIGHT][sq] & this->pieces(KNIGHT))
+	     | (attacks_bb(BISHOP, sq, occupied) & (this->pieces(BISHOP) | this->pieces(QUEEN)))
+	     | (attacks_bb(ROOK, sq, occupied) & (this->pieces(ROOK) | this->pieces(QUEEN)))
+	     | (PseudoAttacks[KING][sq] & this->pieces(KING));
+}
+
+// Piece values used by the static exchange evaluation
+constexpr Value SeeValue[PIECE_TYPE_NB] = {
+	VALUE_ZERO, PawnValueMg, KnightValueMg, BishopValueMg, RookValueMg, QueenValueMg, VALUE_ZERO, VALUE_ZERO
+};
+
+// Swap algorithm: both sides keep capturing on the target square with
+// their least valuable attacker, x-rays included. Pins are ignored.
+bool Position::see_ge(Move m, Value threshold) const {
+	// Castling, en passant and promotions are treated as even exchanges
+	if (type_of(m) != NORMAL) return VALUE_ZERO >= threshold;
+
+	Square from = from_sq(m), to = to_sq(m);
+
+	int swap = SeeValue[get_piece_type(this->piece_on(to))] - threshold;
+	if (swap < 0) return false;
+
+	swap = SeeValue[get_piece_type(this->piece_on(from))] - swap;
+	if (swap <= 0) return true;
+
+	Bitboard occupied = this->pieces() ^ square_bb(from) ^ square_bb(to);
+	Color stm = get_color(this->piece_on(from));
+	Bitboard attackers = this->attackers_to(to, occupied);
+	Bitboard bishops = this->pieces(BISHOP) | this->pieces(QUEEN);
+	Bitboard rooks = this->pieces(ROOK) | this->pieces(QUEEN);
+	int res = 1;
+
+	while (true) {
+		stm = flip_color(stm);
+		attackers &= occupied;
+
+		Bitboard stmAttackers = attackers & this->pieces(stm);
+		if (!stmAttackers) break;
+
+		res ^= 1;
+
+		// Capture with the least valuable attacker, then add the x-ray
+		// attackers behind it
+		Bitboard bb;
+		if ((bb = stmAttackers & this->pieces(PAWN))) {
+			if ((swap = PawnValueMg - swap) < res) break;
+			occupied ^= square_bb(lsb(bb));
+			attackers |= attacks_bb(BISHOP, to, occupied) & bishops;
+		} else if ((bb = stmAttackers & this->pieces(KNIGHT))) {
+			if ((swap = KnightValueMg - swap) < res) break;
+			occupied ^= square_bb(lsb(bb));
+		} else if ((bb = stmAttackers & this->pieces(BISHOP))) {
+			if ((swap = BishopValueMg - swap) < res) break;
+			occupied ^= square_bb(lsb(bb));
+			attackers |= attacks_bb(BISHOP, to, occupied) & bishops;
+		} else if ((bb = stmAttackers & this->pieces(ROOK))) {
+			if ((swap = RookValueMg - swap) < res) break;
+			occupied ^= square_bb(lsb(bb));
+			attackers |= attacks_bb(ROOK, to, occupied) & rooks;
+		} else if ((bb = stmAttackers & this->pieces(QUEEN))) {
+			if ((swap = QueenValueMg - swap) < res) break;
+			occupied ^= square_bb(lsb(bb));
+			attackers |= (attacks_bb(BISHOP, to, occupied) & bishops)
+			           | (attacks_bb(ROOK, to, occupied) & rooks);
+		} else {
+			// The king can only capture if the other side has no attacker left
+			return (attackers & ~this->pieces(stm)) ? res ^ 1 : res;
+		}
+	}
+
+	return bool(res);
+}
+
+bool Position::can_castle(CastlingRights cr) const {
+	if (!(this->castling_rights() & cr)) return false;
+
+	Color us = this->sideToMove;
+	Color them = flip_color(us);
+
+	Square king_sq = make_square(FILE_E, get_initial_king_rank(us));
+	Square rook_sq = this->castling_rook_square(cr);
+
+	if (this->piece_on(rook_sq) != make_piece(us, ROOK))
+		return false;
+
+	Square king_to = this->castling_king_square(cr);
+	Square rook_to = this->castling_rook_to_square(cr);
+
+	if (path_bb(king_sq, rook_sq) & ~square_bb(king_sq) & ~square_bb(rook_sq) & this->pieces())
+		return false;
+
+	Bitboard king_path = path_bb(king_sq, king_to);
+	while(king_path) {
+		Square s = pop_lsb(king_path);
+		if (square_is_attacked(them, s)) return false;
+	}
+
+	if (this->piece_on(rook_to) != NO_PIECE)
+		return false;
+
+	return true;
+}
+
+void Position::do_null_move(StateInfo& newSt) {
+	// Copy state info
+	newSt.key = this->st->key;
+	newSt.pawnKey = this->st->pawnKey;
+	newSt.materialKey = this->st->materialKey;
+	newSt.castlingRights = this->st->castlingRights;
+	newSt.rule50 = this->st->rule50;
+	newSt.capturedPiece = NO_PIECE;
+	newSt.lastmove = MOVE_NULL;
+	newSt.epSquare = SQ_NONE;
+	newSt.pliesFromNull = 0;
+	newSt.prev = this->st;
+	newSt.dirtyPiece.dirty_num = 0;
+	newSt.accumulator.computed[WHITE] = newSt.accumulator.computed[BLACK] = false;
+
+	if (this->st->epSquare != SQ_NONE) {
+		newSt.key ^= Zobrist::enpassant[get_file(this->st->epSquare)];
+	}
+
+	newSt.key ^= Zobrist::side;
+
+	newSt.rule50++; 
+
+	this->sideToMove = flip_color(this->sideToMove);
+	this->st = &newSt;
+	++this->ply;
+}
+
+void Position::undo_null_move() {
+	this->sideToMove = flip_color(this->sideToMove);
+	this->st = this->st->prev;
+	--this->ply;
+}
+
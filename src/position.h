@@ -1,166 +1,246 @@
-#ifndef POSITION_H_INCLUDED
-#define POSITION_H_INCLUDED
-
-#include "bitboard.h"
-#include "types.h"
-#include <deque>
-#include <memory>
-#include <string>
-#include <iostream>
-
-struct StateInfo {
-	Key key;
-	int castlingRights;
-	int rule50;
-	Piece capturedPiece;
-	Move lastmove;
-	Square epSquare;
-	StateInfo *prev;
-};
-
-typedef std::unique_ptr<std::deque<StateInfo>> StateListPtr;
-
-class Position {
-public:
-	static void init();
-
-	void print_board() const;
-
-	void set(std::string fenStr, StateInfo& st);
-	void set_state_pointer(StateInfo& st);
-
-	const std::string fen() const;
-
-	Bitboard pieces() const;
-	Bitboard pieces(PieceType pt) const;
-	Bitboard pieces(Color c) const;
-	Bitboard pieces(Color c, PieceType pt) const;
-	Piece piece_on(Square s) const;
-	Square ep_square() const;
-	Color side_to_move() const;
-	int rule50() const;
-	Key key() const { return st->key; } 
-
-	int castling_rights() const;
-	int castling_rights(Color c) const;
-	bool can_castle(CastlingRights cr) const;
-	Square castling_king_square(CastlingRights cr) const;
-	Square castling_rook_square(CastlingRights cr) const;
-	Square castling_rook_to_square(CastlingRights cr) const;
-
-	void do_null_move(StateInfo& newSt);
-	void undo_null_move();
-
-	void do_move(Move m, StateInfo& newSt);
-	void undo_move();
-	void generate_moves(svec<Move>& moves);
-
-	bool is_checkmate(bool checkOpponent=false);
-	bool is_draw() const;
-	bool kingIsAttacked(Color c) const;
-	bool is_in_check() const;
-
-	Move string_to_move(std::string str);
-
-	bool square_is_attacked(Color c, Square sq) const;
-
-	bool has_non_pawn_material(Color c) const;
-	
-private:
-	void put_piece(Piece pc, Square sq);
-	void remove_piece(Square sq);
-	void move_piece(Square fr, Square to);
-
-	bool can_move_to(Square from, Square to);
-	bool can_capture_piece(Piece pc);
-
-	bool square_empty(Square sq) const;
-
-	Bitboard generate_attack_bitboard(Color c) const;
-	bool squareIsAttacked(Color c, Square to) const;
-	bool pieceIsAttacked(Color c, PieceType pt) const;
-
-	bool checkStrictlyLegalMove(Move m);
-
-	Piece board[SQ_NB];
-	Bitboard byColorBB[COLOR_NB];
-	Bitboard byTypeBB[PIECE_TYPE_NB];
-	Color sideToMove;
-	int ply;
-	StateInfo *st;
-};
-
-inline Piece Position::piece_on(Square s) const {
-	return this->board[s];
-}
-inline Square Position::ep_square() const {
-	return this->st->epSquare;
-}
-inline Color Position::side_to_move() const {
-	return this->sideToMove;
-}
-
-inline int Position::castling_rights() const {
-	return this->st->castlingRights;
-}
-inline int Position::castling_rights(Color c) const {
-	return this->castling_rights() & get_side(c);
-}
-
-inline Square Position::castling_king_square(CastlingRights cr) const {
-	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
-	Rank r = get_initial_king_rank(c);
-	File f = (cr & QUEEN_SIDE) ? FILE_C : FILE_G;
-	return make_square(f, r);
-}
-
-inline Square Position::castling_rook_square(CastlingRights cr) const {
-	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
-	Rank r = get_initial_king_rank(c);
-	File f = (cr & QUEEN_SIDE) ? FILE_A : FILE_H;
-	return make_square(f, r);
-}
-inline Square Position::castling_rook_to_square(CastlingRights cr) const {
-	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
-	Rank r = get_initial_king_rank(c);
-	File f = (cr & QUEEN_SIDE) ? FILE_D : FILE_F;
-	return make_square(f, r);
-}
-
-inline int Position::rule50() const {
-	return this->st->rule50;
-}
-
-inline Bitboard Position::pieces() const {
-	return this->pieces(WHITE) | this->pieces(BLACK);
-}
-
-inline Bitboard Position::pieces(Color c) const {
-	return this->byColorBB[c];
-}
-
-inline Bitboard Position::pieces(PieceType pt) const {
-	return this->byTypeBB[pt];
-}
-
-inline Bitboard Position::pieces(Color c, PieceType pt) const {
-	return pieces(c) & pieces(pt);
-}
-
-inline bool Position::square_empty(Square sq) const {
-	return this->board[sq] == NO_PIECE;
-}
-
-inline bool Position::square_is_attacked(Color c, Square sq) const {
-	return this->generate_attack_bitboard(c) & square_bb(sq);
-}
-
-inline void Position::set_state_pointer(StateInfo& st) {
-	this->st = &st;
-}
-
-inline bool Position::has_non_pawn_material(Color c) const {
-	return (this->pieces(c) ^ this->pieces(c, PAWN) ^ this->pieces(c, KING));
-}
-
-#endif
+#ifndef POSITION_H_INCLUDED
+#define POSITION_H_INCLUDED
+
+#include "bitboard.h"
+#include "nnue.h"
+#include "types.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <iostream>
+
+class Thread;
+
+struct StateInfo {
+	Key key;
+	Key pawnKey; // pawns only, for the pawn hash table
+	Key materialKey; // piece counts, for the material hash table
+	int castlingRights;
+	int rule50;
+	Piece capturedPiece;
+	Move lastmove;
+	Square epSquare;
+	int pliesFromNull; // plies since the last null move or the root FEN
+	StateInfo *prev;
+
+	// Network input, updated lazily from the move that led here
+	DirtyPiece dirtyPiece;
+	Accumulator accumulator;
+};
+
+typedef std::unique_ptr<std::deque<StateInfo>> StateListPtr;
+
+// A position in 32 bytes, for storing positions in bulk: the occupied
+// squares, then the piece on each of them in square order, four bits each
+struct PackedPosition {
+	uint64_t occupied;
+	uint8_t pieces[16];
+	uint8_t sideToMove;
+	uint8_t castlingRights;
+	uint8_t epSquare; // SQ_NONE without en passant
+	uint8_t rule50;
+	uint16_t fullmoveNumber;
+	uint16_t padding;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+class Position {
+public:
+	static void init();
+
+	void print_board() const;
+
+	void set(std::string fenStr, StateInfo& st);
+	void set(const PackedPosition& pp, StateInfo& st);
+	void set_state_pointer(StateInfo& st);
+
+	const std::string fen() const;
+	// At most 32 pieces
+	PackedPosition pack() const;
+
+	Bitboard pieces() const;
+	Bitboard pieces(PieceType pt) const;
+	Bitboard pieces(Color c) const;
+	Bitboard pieces(Color c, PieceType pt) const;
+	Piece piece_on(Square s) const;
+	Square ep_square() const;
+	Color side_to_move() const;
+	int rule50() const;
+	int game_ply() const;
+	Key key() const { return st->key; } 
+	Key pawn_key() const { return st->pawnKey; }
+	Key material_key() const { return st->materialKey; }
+	int count(Piece pc) const { return pieceCount[pc]; }
+	StateInfo* state() const { return st; }
+
+	// Thread searching this position, whose hash tables eval() uses
+	Thread* this_thread() const { return thisThread; }
+	void set_thread(Thread* th) { thisThread = th; }
+
+	int castling_rights() const;
+	int castling_rights(Color c) const;
+	bool can_castle(CastlingRights cr) const;
+	Square castling_king_square(CastlingRights cr) const;
+	Square castling_rook_square(CastlingRights cr) const;
+	Square castling_rook_to_square(CastlingRights cr) const;
+
+	void do_null_move(StateInfo& newSt);
+	void undo_null_move();
+
+	void do_move(Move m, StateInfo& newSt);
+	void undo_move();
+	void generate_moves(svec<Move>& moves);
+
+	bool is_checkmate(bool checkOpponent=false);
+	bool is_draw() const;
+	// Can the side to move reach a position of the game or the search
+	// tree again with one move? ply is the distance to the root.
+	bool has_game_cycle(int ply) const;
+	bool kingIsAttacked(Color c) const;
+	bool is_in_check() const;
+
+	Move string_to_move(std::string str);
+
+	bool square_is_attacked(Color c, Square sq) const;
+
+	bool has_non_pawn_material(Color c) const;
+
+	// Material and piece-square score, updated incrementally by do_move()
+	Score psq_score() const;
+	Value non_pawn_material(Color c) const;
+	Value non_pawn_material() const;
+
+	// Pieces of both colors attacking sq, given the occupancy
+	Bitboard attackers_to(Square sq, Bitboard occupied) const;
+
+	// Static exchange evaluation: does m win at least threshold?
+	bool see_ge(Move m, Value threshold = VALUE_ZERO) const;
+	
+private:
+	// Empty the board, before setting a position
+	void clear(StateInfo& st);
+	// The keys of the state, from the board and the other state fields
+	void set_keys();
+
+	void put_piece(Piece pc, Square sq);
+	void remove_piece(Square sq);
+	void move_piece(Square fr, Square to);
+
+	bool can_move_to(Square from, Square to);
+	bool can_capture_piece(Piece pc);
+
+	bool square_empty(Square sq) const;
+
+	Bitboard generate_attack_bitboard(Color c) const;
+	bool squareIsAttacked(Color c, Square to) const;
+	bool pieceIsAttacked(Color c, PieceType pt) const;
+
+	bool checkStrictlyLegalMove(Move m);
+
+	Piece board[SQ_NB];
+	Bitboard byColorBB[COLOR_NB];
+	Bitboard byTypeBB[PIECE_TYPE_NB];
+	Color sideToMove;
+	int ply;
+	StateInfo *st;
+	Thread* thisThread = nullptr;
+
+	// Sum of PSQT::psq from White's point of view, and middlegame value of
+	// the knights, bishops, rooks and queens of each side
+	Score psqScore;
+	Value nonPawnMaterial[COLOR_NB];
+	int pieceCount[PIECE_NB];
+};
+
+inline Piece Position::piece_on(Square s) const {
+	return this->board[s];
+}
+inline Square Position::ep_square() const {
+	return this->st->epSquare;
+}
+inline Color Position::side_to_move() const {
+	return this->sideToMove;
+}
+
+inline int Position::castling_rights() const {
+	return this->st->castlingRights;
+}
+inline int Position::castling_rights(Color c) const {
+	return this->castling_rights() & get_side(c);
+}
+
+inline Square Position::castling_king_square(CastlingRights cr) const {
+	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
+	Rank r = get_initial_king_rank(c);
+	File f = (cr & QUEEN_SIDE) ? FILE_C : FILE_G;
+	return make_square(f, r);
+}
+
+inline Square Position::castling_rook_square(CastlingRights cr) const {
+	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
+	Rank r = get_initial_king_rank(c);
+	File f = (cr & QUEEN_SIDE) ? FILE_A : FILE_H;
+	return make_square(f, r);
+}
+inline Square Position::castling_rook_to_square(CastlingRights cr) const {
+	Color c = (cr & WHITE_SIDE) ? WHITE : BLACK;
+	Rank r = get_initial_king_rank(c);
+	File f = (cr & QUEEN_SIDE) ? FILE_D : FILE_F;
+	return make_square(f, r);
+}
+
+inline int Position::rule50() const {
+	return this->st->rule50;
+}
+
+inline int Position::game_ply() const {
+	return this->ply;
+}
+
+inline Bitboard Position::pieces() const {
+	return this->pieces(WHITE) | this->pieces(BLACK);
+}
+
+inline Bitboard Position::pieces(Color c) const {
+	return this->byColorBB[c];
+}
+
+inline Bitboard Position::pieces(PieceType pt) const {
+	return this->byTypeBB[pt];
+}
+
+inline Bitboard Position::pieces(Color c, PieceType pt) const {
+	return pieces(c) & pieces(pt);
+}
+
+inline bool Position::square_empty(Square sq) const {
+	return this->board[sq] == NO_PIECE;
+}
+
+inline bool Position::square_is_attacked(Color c, Square sq) const {
+	return this->generate_attack_bitboard(c) & square_bb(sq);
+}
+
+inline void Position::set_state_pointer(StateInfo& st) {
+	this->st = &st;
+}
+
+inline Score Position::psq_score() const {
+	return this->psqScore;
+}
+
+inline Value Position::non_pawn_material(Color c) const {
+	return this->nonPawnMaterial[c];
+}
+
+inline Value Position::non_pawn_material() const {
+	return this->nonPawnMaterial[WHITE] + this->nonPawnMaterial[BLACK];
+}
+
+inline bool Position::has_non_pawn_material(Color c) const {
+	return this->nonPawnMaterial[c] != VALUE_ZERO;
+}
+
+#endif
@@ -1,390 +1,873 @@
-#include "search.h"
-#include "thread.h"
-#include "evaluation.h"
-#include "position.h"
-#include "types.h"
-#include "transposition.h"
-#include <algorithm>
-#include <chrono>
-#include <cstdint>
-
-struct ScoredMove {
-	Move move;
-	int score;
-};
-
-int score_move(const Position& pos, Move m, const Thread& th, int ply) {
-	// 1. PV Move (Handled by checking against ttMove in the loop, usually gave max score)
-	
-	// 2. Captures (MVV-LVA)
-	if (pos.piece_on(to_sq(m)) != NO_PIECE || type_of(m) == PROMOTION || type_of(m) == ENPASSANT) {
-		int score = 0;
-		if (type_of(m) == PROMOTION) score += 20000;
-		
-		Piece attacker = pos.piece_on(from_sq(m));
-		Piece victim = (type_of(m) == ENPASSANT) ? make_piece(flip_color(pos.side_to_move()), PAWN) 
-												 : pos.piece_on(to_sq(m));
-		
-		if (victim != NO_PIECE) {
-			score += 10000 + 10 * get_piece_type(victim) - get_piece_type(attacker);
-		}
-		return score;
-	}
-
-	// 3. Killer Moves (Quiet moves that caused a cutoff recently)
-	if (ply < MAX_PLY) {
-		if (m == th.killers[ply][0]) return 9000;
-		if (m == th.killers[ply][1]) return 8000;
-	}
-
-	// 4. History Heuristic (Quiet moves that are generally good)
-	// Cap value to avoid overflow if needed, or just return raw history
-	return th.history[pos.piece_on(from_sq(m))][to_sq(m)];
-}
-
-// Update History logic (call this when a quiet move fails high)
-void update_history(const Position& pos, Thread& th, Move m, int depth) {
-	Piece p = pos.piece_on(from_sq(m));
-
-	Square to = to_sq(m);
-	int bonus = depth * depth;
-	
-	// Clamp to prevent overflow
-	if (th.history[p][to] < 20000) 
-		th.history[p][to] += bonus;
-}
-
-void check_time() {
-	if (Threads.stop_search) return;
-
-	auto now = std::chrono::steady_clock::now();
-	// Use start_time stored in SearchLimits
-	auto start = std::chrono::steady_clock::time_point(std::chrono::milliseconds(Threads.limits.start_time));
-	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
-
-	if (elapsed > Threads.limits.allocated_time) {
-		Threads.stop_search = true;
-	}
-}
-
-Value qsearch(Position& pos, StateListPtr& dq, Value alpha, Value beta, Thread &th) {
-	if ((++th.nodes & 2047) == 0) check_time();
-	if (Threads.stop_search) return VALUE_ZERO;
-
-	Value stand_pat = eval(pos);
-	if (stand_pat >= beta) return beta;
-	if (alpha < stand_pat) alpha = stand_pat;
-
-	svec<Move> moves;
-	pos.generate_moves(moves);
-	
-	svec<ScoredMove> scored_moves;
-	for (Move m : moves) {
-		bool is_captured = (pos.piece_on(to_sq(m)) != NO_PIECE) || (type_of(m) == ENPASSANT);
-		bool is_promotion = (type_of(m) == PROMOTION);
-
-		if (!is_captured && !is_promotion) continue;
-
-		int s = score_move(pos, m, th, MAX_PLY);
-		scored_moves.push_back({m, s});
-	}
-
-	std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
-		return a.score > b.score;
-	});
-
-	for (const auto& sm : scored_moves) {
-		Move m = sm.move;
-		dq->emplace_back();
-		pos.do_move(m, dq->back());
-		Value val = -qsearch(pos, dq, -beta, -alpha, th);
-		pos.undo_move();
-		dq->pop_back();
-
-		if (val >= beta) return beta;
-		if (val > alpha) alpha = val;
-	}
-	return alpha;
-}
-
-Value search(Position& pos, StateListPtr& dq, int depth, int ply, Value alpha, Value beta, Thread &th) {
-	if ((++th.nodes & 2047) == 0) check_time();
-	if (Threads.stop_search) return VALUE_ZERO;
-
-	if (pos.is_draw()) return VALUE_DRAW;
-	alpha = std::max(alpha, Value(-VALUE_MATE + ply));
-	beta = std::min(beta, Value(VALUE_MATE - ply + 1));
-	if (alpha >= beta) return alpha;
-
-	Key key = pos.key();
-	TTEntry tte = ttable.get(key);
-	Move tt_move = MOVE_NONE;
-	if (tte.key == uint64_t(key)) {
-		tt_move = Move(tte.move);
-		if (tte.depth >= depth) {
-			Value ttValue = TranspositionTable::value_from_tt(Value(tte.value), ply);
-			Bound b = get_bound_type(tte.genbound);
-			if (b == BOUND_EXACT) return ttValue;
-			if (b == BOUND_LOWER && ttValue >= beta) return ttValue;
-			if (b == BOUND_UPPER && ttValue <= alpha) return ttValue;
-		}
-	}
-
-	bool in_check = pos.is_in_check();
-	if (in_check) ++depth;
-
-	if (depth <= 0 && !in_check) return qsearch(pos, dq, alpha, beta, th);
-
-	if (!in_check && depth >= 3 && pos.has_non_pawn_material(pos.side_to_move())) {
-		int R = (depth > 6) ? 3 : 2;
-
-		dq->emplace_back();
-		pos.do_null_move(dq->back());
-
-		Value nullValue = -search(pos, dq, depth - 1 - R, ply + 1, -beta, Value(-beta + 1), th);
-
-		pos.undo_null_move();
-		dq->pop_back();
-
-		if (Threads.stop_search) return VALUE_ZERO;
-		if (nullValue >= beta) {
-			if (nullValue >= VALUE_MATE_IN_MAX_PLY) return beta;
-			return nullValue;
-		}
-	}
-
-	if (depth < 4 && !in_check && alpha < VALUE_MATE_IN_MAX_PLY && beta > VALUE_MATED_IN_MAX_PLY) {
-		int static_eval = eval(pos);
-		int margin = 128 * depth;
-		if (static_eval + margin < alpha) {
-			return qsearch(pos, dq, alpha, beta, th);
-		}
-	}
-
-	svec<Move> moves;
-	pos.generate_moves(moves);
-	if (moves.empty()) {
-		if (in_check) return Value(-VALUE_MATE + ply);
-		return VALUE_DRAW;
-	}
-
-	svec<ScoredMove> scored_moves;
-	for (Move m : moves) {
-		int s = score_move(pos, m, th, ply);
-		if (m == tt_move) s += 40000;
-		scored_moves.push_back({m, s});
-	}
-	std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
-		return a.score > b.score;
-	});
-
-	Value best_val = -VALUE_INFINITE;
-	Move best_move = MOVE_NONE;
-	Bound bound = BOUND_UPPER;
-
-	int moves_searched = 0;
-
-	for (const auto& sm : scored_moves) {
-		Move m = sm.move;
-		bool is_capture = (pos.piece_on(to_sq(m)) != NO_PIECE) || (type_of(m) == PROMOTION);
-
-		dq->emplace_back();
-		pos.do_move(m, dq->back());
-
-		Value val;
-		if (moves_searched == 0) {
-			val = -search(pos, dq, depth - 1, ply + 1, -beta, -alpha, th);
-		} else {
-			// Late Moves
-			// Calculation Reduction (LMR)
-			int reduction = 0;
-			// Conditions: Depth is high, move is ordered late, not a capture/check
-			if (depth >= 3 && moves_searched > 3 && !is_capture && !in_check) {
-				reduction = 1;
-				if (moves_searched > 8) reduction = 2; // Reduce more for very late moves
-				if (depth > 8) reduction += 1; // Reduce more at high depth
-			}
-
-			// Search with Zero Window (Null Window) + Reduction
-			// We expect this move to fail low (val <= alpha)
-			val = -search(pos, dq, depth - 1 - reduction, ply + 1, Value(-alpha - 1), -alpha, th);
-
-			// Re-search 1: If LMR failed (move was better than expected), search again unreduced (but still Zero Window)
-			if (val > alpha && reduction > 0) {
-				val = -search(pos, dq, depth - 1, ply + 1, Value(-alpha - 1), -alpha, th);
-			}
-
-			// Re-search 2: If Zero Window failed (move improves alpha), search again with Full Window
-			if (val > alpha && val < beta) {
-				val = -search(pos, dq, depth - 1, ply + 1, -beta, -alpha, th);
-			}
-		}
-
-		pos.undo_move();
-		dq->pop_back();
-
-		if (Threads.stop_search) return VALUE_ZERO;
-		++moves_searched;
-
-		if (val > best_val) {
-			best_val = val;
-			best_move = m;
-			if (val > alpha) {
-				alpha = val;
-				bound = BOUND_EXACT; // Tìm thấy nước tốt, cập nhật thành Exact Bound
-			}
-		}
-
-		if (alpha >= beta) {
-			// Beta Cutoff (Fail High)
-			bound = BOUND_LOWER;
-			
-			// --- UPDATE KILLER & HISTORY HEURISTICS ---
-			if (!is_capture && ply < MAX_PLY) {
-				// Store Killer
-				if (th.killers[ply][0] != m) {
-					th.killers[ply][1] = th.killers[ply][0];
-					th.killers[ply][0] = m;
-				}
-				// Update History
-				update_history(pos, th, m, depth);
-			}
-			break; 
-		}
-	}
-
-	Value tt_val_to_store = TranspositionTable::value_to_tt(best_val, ply);
-	ttable.set(key, TTEntry(key, best_move, SCORE_ZERO, Score(tt_val_to_store), 0, false, bound, depth));
-
-	return best_val;
-}
-
-void get_pv(Position& pos, std::vector<Move>& pv) {
-	StateInfo st[64];
-	int count = 0;
-	
-	// Prevent infinite loops with a simple depth limit
-	for (int i = 0; i < 64; ++i) {
-		TTEntry tte = ttable.get(pos.key());
-		Move m = Move(tte.move);
-		
-		// If no move in TT or move is invalid/illegal, stop
-		if (m == MOVE_NONE) break;
-		
-		// Verify pseudo-legality (basic check)
-		// Ideally we check strictly legal, but for PV display 
-		// we assume TT contains valid moves from search.
-		// We verify if it is a pseudo-legal move generated by the position.
-		svec<Move> moves;
-		pos.generate_moves(moves);
-		bool found = false;
-		for (Move mv : moves) {
-			if (mv == m) { found = true; break; }
-		}
-		
-		if (!found) break;
-
-		// Execute move to get to next position
-		pos.do_move(m, st[i]);
-		pv.push_back(m);
-		count++;
-	}
-
-	// Undo all moves to restore board state
-	for (int i = 0; i < count; ++i) {
-		pos.undo_move();
-	}
-}
-
-void search_root (Thread& th) {
-	Position& pos = th.pos;
-	StateListPtr& dq = th.states;
-
-	th.clear_heuristics();
-
-	int max_depth = (Threads.limits.depth > 0) ? Threads.limits.depth : 64;
-	Move best_root_move = MOVE_NONE;
-
-	auto start_time = std::chrono::steady_clock::now();
-	Threads.limits.start_time = std::chrono::duration_cast<std::chrono::milliseconds>(start_time.time_since_epoch()).count();
-
-	for (int depth = 1; depth <= max_depth; ++depth) {
-		if (Threads.stop_search) break;
-
-		Value best_val = -VALUE_INFINITE;
-		Value alpha = -VALUE_INFINITE;
-		Value beta = VALUE_INFINITE;
-
-		svec<Move> moves;
-		pos.generate_moves(moves);
-		
-		svec<ScoredMove> scored_moves;
-		for (Move m : moves) {
-			int s = score_move(pos, m, th, MAX_PLY);
-			if (m == best_root_move) s += 30000;
-			scored_moves.push_back({m, s});
-		}
-		std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
-			return a.score > b.score;
-		});
-
-		Move current_best_move = MOVE_NONE;
-		for (const auto& sm : scored_moves) {
-			if (Threads.stop_search) break;
-
-			Move m = sm.move;
-			dq->emplace_back();
-			pos.do_move(m, dq->back());
-
-			Value val = -search(pos, dq, depth - 1, 1, -beta, -alpha, th);
-
-			pos.undo_move();
-			dq->pop_back();
-
-			if (val > best_val) {
-				best_val = val;
-				current_best_move = m;
-				alpha = val;
-			}
-		}
-
-		if (!Threads.stop_search) {
-			best_root_move = current_best_move;
-
-			auto now = std::chrono::steady_clock::now();
-			auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count();
-			if (best_root_move != MOVE_NONE) {
-				std::cout << "info depth " << depth 
-						  << " score cp " << best_val 
-						  << " nodes " << th.nodes 
-						  << " time " << elapsed 
-						  << " pv";
-
-				// Get the actual PV line from TT
-				std::vector<Move> pv_line;
-				// We must manually add the root move because TT might not be updated 
-				// for the root position until the *end* of the search, 
-				// or if we rely on the loop's 'best_root_move'.
-				// However, standard engine practice: do_move(best), get_pv, undo.
-				
-				std::cout << " " << move_to_str(best_root_move);
-				
-				StateInfo st_temp;
-				pos.do_move(best_root_move, st_temp);
-				get_pv(pos, pv_line);
-				pos.undo_move();
-
-				for (Move m : pv_line) {
-					std::cout << " " << move_to_str(m);
-				}
-
-				std::cout << std::endl;
-			}
-		}
-	}
-
-	if (th.id == 0) {
-		std::cout << "bestmove " << move_to_str(best_root_move) << std::endl;
-	}
-}
-
+#include "search.h"
+#include "thread.h"
+#include "evaluation.h"
+#include "option.h"
+#include "position.h"
+#include "types.h"
+#include "transposition.h"
+#include "timeman.h"
+#include "uci.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Search is specialized at compile time for each node type: zero-window
+// nodes skip all PV bookkeeping, and the root node shares the move loop
+// with the other nodes but iterates over the root move list.
+enum NodeType { NonPV, PV, Root };
+
+// Late move reductions, indexed by [depth][moveCount]
+int Reductions[64][64];
+
+// Quiet moves searched after this count are pruned at low depth
+constexpr int LMP_DEPTH = 8;
+int LateMoveCount[LMP_DEPTH];
+
+void Search::init() {
+	double base = get_option_int("LMR Base") / 100.0;
+	double divisor = get_option_int("LMR Divisor") / 100.0;
+	for (int d = 1; d < 64; ++d) {
+		for (int mc = 1; mc < 64; ++mc) {
+			Reductions[d][mc] = int(base + std::log(d) * std::log(mc) / divisor);
+		}
+	}
+
+	int lmp_base = get_option_int("LMP Base");
+	int lmp_factor = get_option_int("LMP Factor");
+	for (int d = 0; d < LMP_DEPTH; ++d) {
+		LateMoveCount[d] = (lmp_base + lmp_factor * d * d) / 100;
+	}
+}
+
+void Search::on_param_change(const Option&) {
+	Search::init();
+}
+
+inline int reduction(int depth, int moveCount) {
+	return Reductions[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+struct ScoredMove {
+	Move move;
+	int score;
+};
+
+// Move ordering: the TT move first, then captures and promotions by
+// MVV-LVA, the killers and the countermove, and the other quiet moves by
+// their history scores.
+constexpr int TT_MOVE_SCORE = 4000000;
+constexpr int CAPTURE_SCORE = 1000000;
+constexpr int KILLER_SCORE = 900000;
+constexpr int COUNTER_MOVE_SCORE = 700000;
+
+// Quiet move score from the butterfly and continuation histories
+int quiet_history(const Position& pos, Move m, const Thread& th, const Stack* ss) {
+	Piece pc = pos.piece_on(from_sq(m));
+	Square to = to_sq(m);
+	return th.mainHistory[pos.side_to_move()][from_to(m)]
+	     + 2 * (*(ss - 1)->continuationHistory)[pc][to]
+	     + (*(ss - 2)->continuationHistory)[pc][to];
+}
+
+inline bool is_capture_or_promotion(const Position& pos, Move m) {
+	return pos.piece_on(to_sq(m)) != NO_PIECE || type_of(m) == PROMOTION || type_of(m) == ENPASSANT;
+}
+
+// Type of the piece captured by m, NO_PIECE_TYPE for a quiet promotion
+inline PieceType captured_type(const Position& pos, Move m) {
+	return type_of(m) == ENPASSANT ? PAWN : get_piece_type(pos.piece_on(to_sq(m)));
+}
+
+// Capture history entry of m
+inline StatsEntry<10692>& capture_history(const Position& pos, Thread& th, Move m) {
+	return th.captureHistory[pos.piece_on(from_sq(m))][to_sq(m)][captured_type(pos, m)];
+}
+
+int score_move(const Position& pos, Move m, const Thread& th, const Stack* ss) {
+	// Captures: MVV first, then the capture history, which learns which
+	// captures of a same victim actually cut off
+	if (is_capture_or_promotion(pos, m)) {
+		int score = CAPTURE_SCORE;
+		if (type_of(m) == PROMOTION) score += 20000;
+
+		PieceType victim = captured_type(pos, m);
+		if (victim != NO_PIECE_TYPE) {
+			score += 10000 + 2000 * victim;
+		}
+		score += th.captureHistory[pos.piece_on(from_sq(m))][to_sq(m)][victim] / 4;
+		return score;
+	}
+
+	// Killer moves (quiet moves that caused a cutoff at the same ply)
+	if (ss->ply < MAX_PLY) {
+		if (m == th.killers[ss->ply][0]) return KILLER_SCORE + 1;
+		if (m == th.killers[ss->ply][1]) return KILLER_SCORE;
+	}
+
+	// Countermove (the last refutation of the previous move)
+	Move prev = (ss - 1)->currentMove;
+	if (is_ok(prev)) {
+		Square prevSq = to_sq(prev);
+		if (m == th.counterMoves[pos.piece_on(prevSq)][prevSq]) return COUNTER_MOVE_SCORE;
+	}
+
+	return quiet_history(pos, m, th, ss);
+}
+
+// History bonus for a move that failed high at the given depth
+inline int stat_bonus(int depth) {
+	return std::min(16 * depth * depth + 128 * depth - 128, 2000);
+}
+
+// Update the continuation histories of the move pair formed by the piece
+// moving to "to" and each of the two previous moves
+void update_continuation_histories(Stack* ss, Piece pc, Square to, int bonus) {
+	for (int i : {1, 2}) {
+		if (is_ok((ss - i)->currentMove)) {
+			(*(ss - i)->continuationHistory)[pc][to].update(bonus);
+		}
+	}
+}
+
+// A quiet move failed high: reward it and punish the quiet moves searched
+// before it, which did not.
+void update_quiet_stats(const Position& pos, Stack* ss, Thread& th, Move m,
+		const svec<Move>& quiets, int bonus) {
+	if (th.killers[ss->ply][0] != m) {
+		th.killers[ss->ply][1] = th.killers[ss->ply][0];
+		th.killers[ss->ply][0] = m;
+	}
+
+	Color us = pos.side_to_move();
+	th.mainHistory[us][from_to(m)].update(bonus);
+	update_continuation_histories(ss, pos.piece_on(from_sq(m)), to_sq(m), bonus);
+
+	Move prev = (ss - 1)->currentMove;
+	if (is_ok(prev)) {
+		Square prevSq = to_sq(prev);
+		th.counterMoves[pos.piece_on(prevSq)][prevSq] = m;
+	}
+
+	for (Move q : quiets) {
+		if (q == m) continue;
+		th.mainHistory[us][from_to(q)].update(-bonus);
+		update_continuation_histories(ss, pos.piece_on(from_sq(q)), to_sq(q), -bonus);
+	}
+}
+
+// Only the owning thread writes its node counter, so a relaxed load and
+// store is enough and avoids a locked increment at every node.
+inline void inc_nodes(Thread& th) {
+	th.nodes.store(th.nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// A node limit ("go nodes", "nodestime") can't be enforced by the timer
+// thread, so the main thread compares the total node count of all threads
+// against it every 128 of its own nodes.
+inline void check_node_limit(const Thread& th) {
+	if (Threads.limits.nodes && th.id == 0
+	 && (th.nodes.load(std::memory_order_relaxed) & 127) == 0
+	 && Threads.nodes_searched() >= Threads.limits.nodes) {
+		Threads.stop_search = true;
+	}
+}
+
+// Append move and the child's PV to the PV of the current node
+void update_pv(Move* pv, Move move, const Move* childPv) {
+	for (*pv++ = move; childPv && *childPv != MOVE_NONE; )
+		*pv++ = *childPv++;
+	*pv = MOVE_NONE;
+}
+
+// Values of the captured piece used by delta pruning, indexed by PieceType
+constexpr Value DeltaValue[PIECE_TYPE_NB] = {
+	VALUE_ZERO, PawnValueEg, KnightValueEg, BishopValueEg, RookValueEg, QueenValueEg, VALUE_ZERO, VALUE_ZERO
+};
+
+// Quiescence search: only captures and promotions are searched, except
+// when in check where standing pat is not an option and all evasions are
+// searched. Depth is 0 at the first qsearch ply and decreases after that.
+template <NodeType NT>
+Value qsearch(Position& pos, Stack* ss, Value alpha, Value beta, int depth, Thread &th) {
+	constexpr bool PvNode = NT == PV;
+
+	Move pv[MAX_PLY + 1];
+	if (PvNode) {
+		(ss + 1)->pv = pv;
+		ss->pv[0] = MOVE_NONE;
+	}
+
+	inc_nodes(th);
+	check_node_limit(th);
+	if (Threads.stop_search) return VALUE_ZERO;
+
+	bool in_check = pos.is_in_check();
+
+	if (pos.is_draw()) return VALUE_DRAW;
+	if (ss->ply >= MAX_PLY) return in_check ? VALUE_DRAW : eval(pos);
+
+	Key key = pos.key();
+	TTEntry tte = ttable.get(key);
+	bool tt_hit = tte.key == uint64_t(key);
+	Move tt_move = tt_hit ? Move(tte.move) : MOVE_NONE;
+	Value tt_value = tt_hit ? TranspositionTable::value_from_tt(Value(tte.value), ss->ply) : VALUE_NONE;
+	Bound tt_bound = tt_hit ? get_bound_type(tte.genbound) : BOUND_NONE;
+
+	if (!PvNode && tt_hit && tte.get_depth() >= DEPTH_QS && tt_value != VALUE_NONE
+	 && (tt_bound & (tt_value >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+		return tt_value;
+	}
+
+	Value old_alpha = alpha;
+	Value best_val;
+	Value futility_base;
+	if (in_check) {
+		ss->staticEval = VALUE_NONE;
+		best_val = futility_base = -VALUE_INFINITE;
+	} else {
+		// Reuse the static evaluation stored in the TT
+		if (tt_hit && tte.eval != VALUE_NONE) {
+			ss->staticEval = best_val = Value(tte.eval);
+		} else {
+			// Only the stand pat needs it, so the evaluation may stop early
+			// when the position is far outside the window. Such a value is
+			// not a static evaluation, and is not stored in the TT.
+			bool lazy;
+			best_val = eval(pos, alpha, beta, lazy);
+			ss->staticEval = lazy ? VALUE_NONE : best_val;
+		}
+
+		// The TT value is a better estimate when its bound allows it
+		if (tt_value != VALUE_NONE
+		 && (tt_bound & (tt_value > best_val ? BOUND_LOWER : BOUND_UPPER))) {
+			best_val = tt_value;
+		}
+
+		// Stand pat
+		if (best_val >= beta) {
+			if (!tt_hit) {
+				ttable.set(key, TTEntry(key, MOVE_NONE, ss->staticEval,
+					TranspositionTable::value_to_tt(best_val, ss->ply), 0, false, BOUND_LOWER, DEPTH_NONE));
+			}
+			return best_val;
+		}
+		if (best_val > alpha) alpha = best_val;
+
+		futility_base = Value(best_val + 155);
+	}
+
+	svec<Move> moves;
+	pos.generate_moves(moves);
+	
+	svec<ScoredMove> scored_moves;
+	for (Move m : moves) {
+		if (!in_check && !is_capture_or_promotion(pos, m)) continue;
+
+		int s = score_move(pos, m, th, ss);
+		if (m == tt_move) s += TT_MOVE_SCORE;
+		scored_moves.push_back({m, s});
+	}
+
+	std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
+		return a.score > b.score;
+	});
+
+	Move best_move = MOVE_NONE;
+	StateInfo st;
+	for (const auto& sm : scored_moves) {
+		Move m = sm.move;
+
+		// Delta pruning: even winning the captured piece for free does not
+		// bring the score back to alpha
+		if (!in_check && futility_base > -VALUE_KNOWN_WIN && type_of(m) != PROMOTION) {
+			Value futility_value = Value(futility_base + DeltaValue[captured_type(pos, m)]);
+			if (futility_value <= alpha) {
+				best_val = std::max(best_val, futility_value);
+				continue;
+			}
+		}
+
+		ss->currentMove = m;
+		ss->continuationHistory = &th.continuationHistory[pos.piece_on(from_sq(m))][to_sq(m)];
+		pos.do_move(m, st);
+		Value val = -qsearch<NT>(pos, ss + 1, -beta, -alpha, depth - 1, th);
+		pos.undo_move();
+
+		if (Threads.stop_search) return VALUE_ZERO;
+
+		if (val > best_val) {
+			best_val = val;
+			if (val > alpha) {
+				best_move = m;
+				if (PvNode) update_pv(ss->pv, m, (ss + 1)->pv);
+				if (val >= beta) break;
+				alpha = val;
+			}
+		}
+	}
+
+	// All evasions were searched: no legal move means checkmate
+	if (in_check && best_val == -VALUE_INFINITE) {
+		return Value(-VALUE_MATE + ss->ply);
+	}
+
+	Bound bound = best_val >= beta ? BOUND_LOWER
+	            : PvNode && best_val > old_alpha ? BOUND_EXACT : BOUND_UPPER;
+	ttable.set(key, TTEntry(key, best_move, ss->staticEval,
+		TranspositionTable::value_to_tt(best_val, ss->ply), 0, false, bound, DEPTH_QS));
+
+	return best_val;
+}
+
+template <NodeType NT>
+Value search(Position& pos, Stack* ss, Value alpha, Value beta, int depth, Thread &th) {
+	constexpr bool PvNode = NT != NonPV;
+	constexpr bool rootNode = NT == Root;
+
+	Move pv[MAX_PLY + 1];
+	if (PvNode) {
+		(ss + 1)->pv = pv;
+		ss->pv[0] = MOVE_NONE;
+	}
+
+	inc_nodes(th);
+	check_node_limit(th);
+	if (Threads.stop_search) return VALUE_ZERO;
+
+	bool in_check = pos.is_in_check();
+
+	if (!rootNode) {
+		if (pos.is_draw()) return VALUE_DRAW;
+		if (ss->ply >= MAX_PLY) return in_check ? VALUE_DRAW : eval(pos);
+
+		// The side to move can repeat a position: the score is at least a draw
+		if (alpha < VALUE_DRAW && pos.has_game_cycle(ss->ply)) {
+			alpha = VALUE_DRAW;
+			if (alpha >= beta) return alpha;
+		}
+
+		// Mate distance pruning
+		alpha = std::max(alpha, Value(-VALUE_MATE + ss->ply));
+		beta = std::min(beta, Value(VALUE_MATE - ss->ply + 1));
+		if (alpha >= beta) return alpha;
+	}
+
+	// A search excluding a move is a different search of the same position:
+	// it gets its own TT key so that it doesn't overwrite the full search
+	Move excluded_move = ss->excludedMove;
+	Key key = pos.key() ^ (Key(excluded_move) << 16);
+	TTEntry tte = ttable.get(key);
+	bool tt_hit = tte.key == uint64_t(key);
+	Move tt_move = MOVE_NONE;
+	Value tt_value = VALUE_NONE;
+	Bound tt_bound = BOUND_NONE;
+	if (tt_hit) {
+		tt_move = Move(tte.move);
+		tt_value = TranspositionTable::value_from_tt(Value(tte.value), ss->ply);
+		tt_bound = get_bound_type(tte.genbound);
+
+		// No cutoffs at PV nodes, so that the PV stays complete
+		if (!PvNode && tte.get_depth() >= depth && tt_value != VALUE_NONE) {
+			if (tt_bound == BOUND_EXACT) return tt_value;
+			if (tt_bound == BOUND_LOWER && tt_value >= beta) return tt_value;
+			if (tt_bound == BOUND_UPPER && tt_value <= alpha) return tt_value;
+		}
+	}
+
+	if (in_check) ++depth;
+
+	if (depth <= 0) return qsearch<PvNode ? PV : NonPV>(pos, ss, alpha, beta, 0, th);
+
+	// Static evaluation, computed at most once per position: it is stored
+	// in the TT and reused when the position is visited again.
+	Value static_eval;
+	bool improving;
+	if (in_check) {
+		ss->staticEval = static_eval = VALUE_NONE;
+		improving = false;
+	} else if (excluded_move) {
+		// Same node as the parent search, which already evaluated it
+		static_eval = ss->staticEval;
+		improving = (ss - 2)->staticEval == VALUE_NONE || ss->staticEval > (ss - 2)->staticEval;
+	} else {
+		if (tt_hit && tte.eval != VALUE_NONE) {
+			ss->staticEval = static_eval = Value(tte.eval);
+		} else {
+			ss->staticEval = static_eval = eval(pos);
+			// An entry without an eval, e.g. from a lazy qsearch stand pat,
+			// keeps its move, value, bound and depth
+			if (tt_hit) {
+				tte.eval = int16_t(static_eval);
+				ttable.set(key, tte);
+			} else {
+				ttable.set(key, TTEntry(key, MOVE_NONE, static_eval, VALUE_NONE, 0, false, BOUND_NONE, DEPTH_NONE));
+			}
+		}
+
+		// The TT value is a better estimate when its bound allows it
+		if (tt_value != VALUE_NONE
+		 && (tt_bound & (tt_value > static_eval ? BOUND_LOWER : BOUND_UPPER))) {
+			static_eval = tt_value;
+		}
+
+		// Is our position better than two plies ago?
+		improving = (ss - 2)->staticEval == VALUE_NONE || ss->staticEval > (ss - 2)->staticEval;
+	}
+
+	// Reverse futility pruning (static null move): the static evaluation is
+	// so far above beta that a quiet move will hardly lose the advantage
+	if (!PvNode && !in_check && !excluded_move && depth < 7
+	 && static_eval - 170 * (depth - improving) >= beta
+	 && static_eval < VALUE_KNOWN_WIN) {
+		return static_eval;
+	}
+
+	// Null move pruning, only at zero-window nodes and never twice in a row
+	if (!PvNode && !in_check && !excluded_move && depth >= 3 && (ss - 1)->currentMove != MOVE_NULL
+	 && static_eval >= beta
+	 && pos.has_non_pawn_material(pos.side_to_move())) {
+		int R = (depth > 6) ? 3 : 2;
+
+		StateInfo st;
+		ss->currentMove = MOVE_NULL;
+		ss->continuationHistory = &th.continuationHistory[NO_PIECE][0];
+		pos.do_null_move(st);
+
+		Value nullValue = -search<NonPV>(pos, ss + 1, -beta, Value(-beta + 1), depth - 1 - R, th);
+
+		pos.undo_null_move();
+
+		if (Threads.stop_search) return VALUE_ZERO;
+		if (nullValue >= beta) {
+			if (nullValue >= VALUE_MATE_IN_MAX_PLY) return beta;
+			return nullValue;
+		}
+	}
+
+	// ProbCut: if a good capture beats beta by a margin in a shallow search,
+	// the full depth search will very likely fail high as well. Captures
+	// are first verified with qsearch, and only the ones that win enough
+	// material by SEE are tried.
+	if (!PvNode && !in_check && !excluded_move && depth >= 5
+	 && std::abs(beta) < VALUE_MATE_IN_MAX_PLY) {
+		Value raised_beta = Value(std::min(beta + 200, VALUE_MATE_IN_MAX_PLY - 1));
+
+		svec<Move> moves;
+		pos.generate_moves(moves);
+		svec<ScoredMove> captures;
+		for (Move m : moves) {
+			if (is_capture_or_promotion(pos, m) && pos.see_ge(m, Value(raised_beta - static_eval))) {
+				captures.push_back({m, score_move(pos, m, th, ss)});
+			}
+		}
+		std::sort(captures.begin(), captures.end(), [](const ScoredMove& a, const ScoredMove& b) {
+			return a.score > b.score;
+		});
+
+		StateInfo st;
+		int probcut_count = 0;
+		for (const auto& sm : captures) {
+			if (probcut_count++ >= 3) break;
+
+			Move m = sm.move;
+			ss->currentMove = m;
+			ss->continuationHistory = &th.continuationHistory[pos.piece_on(from_sq(m))][to_sq(m)];
+			pos.do_move(m, st);
+
+			Value val = -qsearch<NonPV>(pos, ss + 1, -raised_beta, Value(-raised_beta + 1), 0, th);
+			if (val >= raised_beta) {
+				val = -search<NonPV>(pos, ss + 1, -raised_beta, Value(-raised_beta + 1), depth - 4, th);
+			}
+
+			pos.undo_move();
+
+			if (Threads.stop_search) return VALUE_ZERO;
+			if (val >= raised_beta) return val;
+		}
+	}
+
+	// Razoring
+	if (!PvNode && depth < 4 && !in_check && !excluded_move && alpha < VALUE_MATE_IN_MAX_PLY && beta > VALUE_MATED_IN_MAX_PLY) {
+		int margin = 128 * depth;
+		if (static_eval + margin < alpha) {
+			return qsearch<NonPV>(pos, ss, alpha, beta, 0, th);
+		}
+	}
+
+	// Internal iterative reduction: without a TT move the move ordering is
+	// poor and the node was likely not searched before, so spend less on it
+	// (more at PV nodes, where a TT miss is unexpected)
+	if (!rootNode && !excluded_move && tt_move == MOVE_NONE && depth >= 4) {
+		depth -= PvNode ? 2 : 1;
+	}
+
+	// The root iterates over the root moves, ordered by the last iteration
+	svec<ScoredMove> scored_moves;
+	if (rootNode) {
+		for (const RootMove& rm : th.rootMoves) {
+			scored_moves.push_back({rm.pv[0], 0});
+		}
+	} else {
+		svec<Move> moves;
+		pos.generate_moves(moves);
+		if (moves.empty()) {
+			if (in_check) return Value(-VALUE_MATE + ss->ply);
+			return VALUE_DRAW;
+		}
+
+		for (Move m : moves) {
+			int s = score_move(pos, m, th, ss);
+			if (m == tt_move) s += TT_MOVE_SCORE;
+			scored_moves.push_back({m, s});
+		}
+		std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
+			return a.score > b.score;
+		});
+	}
+
+	Value best_val = -VALUE_INFINITE;
+	Move best_move = MOVE_NONE;
+
+	int moves_searched = 0;
+	svec<Move> quiets_searched, captures_searched;
+	StateInfo st;
+
+	for (const auto& sm : scored_moves) {
+		Move m = sm.move;
+		if (m == excluded_move) continue;
+
+		bool is_capture = is_capture_or_promotion(pos, m);
+
+		// Move count pruning: at low depth, once enough moves have been
+		// searched, the remaining quiet moves are very unlikely to raise alpha
+		if (!rootNode && !in_check && !is_capture && depth < LMP_DEPTH
+		 && best_val > VALUE_MATED_IN_MAX_PLY
+		 && moves_searched >= LateMoveCount[depth]) {
+			continue;
+		}
+
+		if (rootNode) {
+			th.currMove = m;
+			th.currMoveNumber = moves_searched + 1;
+		}
+
+		// Reduce late quiet moves, less at PV nodes and for moves with a
+		// good history, more for moves with a bad one
+		int r = 0;
+		if (depth >= 3 && moves_searched > 1 + rootNode && !is_capture && !in_check) {
+			r = reduction(depth, moves_searched + 1);
+			if (PvNode) --r;
+			if (m == th.killers[ss->ply][0] || m == th.killers[ss->ply][1]) --r;
+			r -= quiet_history(pos, m, th, ss) / 24000;
+			if (!improving) ++r;
+			r = std::clamp(r, 0, depth - 2);
+		}
+
+		// Futility pruning: a quiet move can't bring a position far below
+		// alpha back above it at the (reduced) depth left
+		if (!rootNode && !in_check && !is_capture && best_val > VALUE_MATED_IN_MAX_PLY) {
+			int lmr_depth = depth - 1 - r;
+			if (lmr_depth < 7 && static_eval + 200 + 170 * lmr_depth <= alpha) {
+				continue;
+			}
+		}
+
+		// Singular extension: if all the moves but the TT move fail low
+		// against a bound a bit below the TT value, the TT move is forced
+		// and is searched one ply deeper. If another move also beats beta
+		// (multi-cut), the node is very likely to fail high anyway.
+		int extension = 0;
+		if (!rootNode && depth >= 8 && m == tt_move && !excluded_move
+		 && tt_value != VALUE_NONE && std::abs(tt_value) < VALUE_KNOWN_WIN
+		 && (tt_bound & BOUND_LOWER) && tte.get_depth() >= depth - 3) {
+			Value singular_beta = Value(tt_value - 2 * depth);
+			ss->excludedMove = m;
+			Value singular_val = search<NonPV>(pos, ss, Value(singular_beta - 1), singular_beta, (depth - 1) / 2, th);
+			ss->excludedMove = MOVE_NONE;
+
+			if (Threads.stop_search) return VALUE_ZERO;
+			if (singular_val < singular_beta) {
+				extension = 1;
+			} else if (singular_beta >= beta) {
+				return singular_beta;
+			}
+		}
+
+		int new_depth = depth - 1 + extension;
+
+		ss->currentMove = m;
+		ss->continuationHistory = &th.continuationHistory[pos.piece_on(from_sq(m))][to_sq(m)];
+		pos.do_move(m, st);
+
+		Value val;
+		if (moves_searched == 0) {
+			val = -search<PvNode ? PV : NonPV>(pos, ss + 1, -beta, -alpha, new_depth, th);
+		} else {
+			// Search with Zero Window (Null Window) + Reduction
+			// We expect this move to fail low (val <= alpha)
+			val = -search<NonPV>(pos, ss + 1, Value(-alpha - 1), -alpha, new_depth - r, th);
+
+			// Re-search 1: If LMR failed (move was better than expected), search again unreduced (but still Zero Window)
+			if (val > alpha && r > 0) {
+				val = -search<NonPV>(pos, ss + 1, Value(-alpha - 1), -alpha, new_depth, th);
+			}
+
+			// Re-search 2: If Zero Window failed (move improves alpha), search again with Full Window.
+			// At zero-window nodes beta == alpha + 1, so this never happens.
+			if (PvNode && val > alpha && val < beta) {
+				val = -search<PV>(pos, ss + 1, -beta, -alpha, new_depth, th);
+			}
+		}
+
+		pos.undo_move();
+
+		if (Threads.stop_search) return VALUE_ZERO;
+		++moves_searched;
+
+		if (rootNode) {
+			RootMove& rm = *std::find(th.rootMoves.begin(), th.rootMoves.end(), m);
+
+			// The first move and every new best move get an exact score and a
+			// PV. The others only have an upper bound: rank them last.
+			if (moves_searched == 1 || val > alpha) {
+				rm.score = val;
+				rm.pv.resize(1);
+				for (Move* p = (ss + 1)->pv; *p != MOVE_NONE; ++p) {
+					rm.pv.push_back(*p);
+				}
+				if (moves_searched > 1) th.bestMoveChanges += 1.0;
+			} else {
+				rm.score = -VALUE_INFINITE;
+			}
+		}
+
+		if (val > best_val) {
+			best_val = val;
+			if (val > alpha) {
+				best_move = m;
+				if (PvNode && !rootNode) update_pv(ss->pv, m, (ss + 1)->pv);
+				alpha = val;
+			}
+		}
+
+		if (alpha >= beta) {
+			// Beta cutoff: update the killers and the histories. The moves
+			// searched before the cutoff move failed low and get a malus.
+			int bonus = stat_bonus(depth);
+			if (!is_capture) {
+				update_quiet_stats(pos, ss, th, m, quiets_searched, bonus);
+			} else {
+				capture_history(pos, th, m).update(bonus);
+				for (Move q : quiets_searched) {
+					th.mainHistory[pos.side_to_move()][from_to(q)].update(-bonus);
+					update_continuation_histories(ss, pos.piece_on(from_sq(q)), to_sq(q), -bonus);
+				}
+			}
+			for (Move c : captures_searched) {
+				capture_history(pos, th, c).update(-bonus);
+			}
+			break; 
+		}
+
+		if (is_capture) captures_searched.push_back(m);
+		else quiets_searched.push_back(m);
+	}
+
+	// Only the excluded move is legal: let the singular search fail low
+	if (moves_searched == 0 && excluded_move) return alpha;
+
+	Bound bound = best_val >= beta ? BOUND_LOWER
+	            : PvNode && best_move != MOVE_NONE ? BOUND_EXACT : BOUND_UPPER;
+	Value tt_val_to_store = TranspositionTable::value_to_tt(best_val, ss->ply);
+	ttable.set(key, TTEntry(key, best_move, ss->staticEval, tt_val_to_store, 0, false, bound, depth));
+
+	return best_val;
+}
+
+// The PV of the last iteration may end right after the best move (e.g. when
+// an iteration was interrupted): try to find the expected reply in the TT.
+Move ponder_move(Position& pos, const RootMove& rm) {
+	if (rm.pv.size() > 1) return rm.pv[1];
+
+	StateInfo st;
+	pos.do_move(rm.pv[0], st);
+
+	TTEntry tte = ttable.get(pos.key());
+	Move m = MOVE_NONE;
+	if (tte.key == uint64_t(pos.key())) {
+		svec<Move> moves;
+		pos.generate_moves(moves);
+		if (std::find(moves.begin(), moves.end(), Move(tte.move)) != moves.end()) {
+			m = Move(tte.move);
+		}
+	}
+
+	pos.undo_move();
+	return m;
+}
+
+void search_root (Thread& th) {
+	Position& pos = th.pos;
+
+	th.age_heuristics();
+
+	Stack stack[MAX_PLY + 10], *ss = stack + 7;
+	Move pv[MAX_PLY + 1];
+	memset(stack, 0, sizeof(stack));
+	// Entries before the root have no move: their continuation history
+	// points to an entry that is never updated
+	for (int i = 7; i > 0; --i) {
+		(ss - i)->staticEval = VALUE_NONE;
+		(ss - i)->continuationHistory = &th.continuationHistory[NO_PIECE][0];
+	}
+	for (int i = 0; i <= MAX_PLY + 2; ++i) {
+		(ss + i)->ply = i;
+	}
+	ss->pv = pv;
+
+	// Build the root move list, initially ordered like any other node
+	svec<Move> moves;
+	pos.generate_moves(moves);
+	svec<ScoredMove> scored_moves;
+	for (Move m : moves) {
+		scored_moves.push_back({m, score_move(pos, m, th, ss)});
+	}
+	std::sort(scored_moves.begin(), scored_moves.end(), [](const ScoredMove& a, const ScoredMove& b) {
+		return a.score > b.score;
+	});
+	th.rootMoves.clear();
+	for (const auto& sm : scored_moves) {
+		th.rootMoves.emplace_back(sm.move);
+	}
+
+	int max_depth = (Threads.limits.depth > 0) ? Threads.limits.depth : 64;
+	if (th.rootMoves.empty()) {
+		max_depth = 0;
+		sync_cout << "info depth 0 score " << UCI::value(pos.is_in_check() ? -VALUE_MATE : VALUE_DRAW) << sync_endl;
+	}
+
+	// Time management: remember how the best move and the score evolve
+	// between iterations to decide whether to stop early or think longer.
+	Value prev_iter_val = (th.previousScore == VALUE_INFINITE) ? VALUE_ZERO : th.previousScore;
+	Move last_best_move = MOVE_NONE;
+	int last_best_move_depth = 0;
+	th.bestMoveChanges = 0;
+
+	for (int depth = 1; depth <= max_depth; ++depth) {
+		if (Threads.stop_search) break;
+		th.rootDepth = depth;
+
+		// Scores of the last iteration must not rank the moves that this one
+		// does not reach before a stop
+		for (RootMove& rm : th.rootMoves) {
+			rm.previousScore = rm.score;
+			rm.score = -VALUE_INFINITE;
+		}
+
+		search<Root>(pos, ss, -VALUE_INFINITE, VALUE_INFINITE, depth, th);
+
+		// Every move searched before a stop has an exact score or is known to
+		// be worse than the best one, so a partial iteration is still usable:
+		// the previous best move is searched first and is only replaced by a
+		// move proven to be better.
+		std::stable_sort(th.rootMoves.begin(), th.rootMoves.end());
+
+		const RootMove& best = th.rootMoves[0];
+		if (best.pv[0] != last_best_move) {
+			last_best_move = best.pv[0];
+			last_best_move_depth = depth;
+		}
+
+		if (Threads.stop_search) break;
+
+		Value best_val = best.score;
+		TimePoint elapsed = Time.elapsed_time();
+		uint64_t nodes = Threads.nodes_searched();
+		sync_cout << "info depth " << depth 
+				  << " score " << UCI::value(best_val)
+				  << " nodes " << nodes 
+				  << " nps " << nodes * 1000 / std::max(elapsed, TimePoint(1))
+				  << " hashfull " << ttable.hashfull()
+				  << " time " << elapsed 
+				  << " pv";
+		for (Move m : best.pv) {
+			std::cout << " " << move_to_str(m);
+		}
+		std::cout << sync_endl;
+
+		// A mate in the requested number of moves has been proven
+		if (Threads.limits.mate && best_val >= VALUE_MATE_IN_MAX_PLY
+		 && VALUE_MATE - best_val <= 2 * Threads.limits.mate) {
+			break;
+		}
+
+		// Decide whether to start another iteration
+		if (th.id == 0 && Threads.limits.use_time_management() && !Threads.limits.infinite) {
+			// Think longer when the score drops, compared both to the last
+			// iteration and to the search of the previous move
+			double falling_eval = (66 + 12 * (prev_iter_val - best_val)
+			                          + 6 * (th.previousScore == VALUE_INFINITE ? 0 : th.previousScore - best_val)) / 616.0;
+			falling_eval = std::clamp(falling_eval, 0.5, 1.5);
+
+			// Think less when the best move has been stable for many iterations
+			double stability = (last_best_move_depth + 8 < depth) ? 0.65 : 1.0;
+
+			// Think longer when the best move changed recently
+			double instability = 1.0 + 1.5 * th.bestMoveChanges;
+			th.bestMoveChanges /= 2;
+
+			double total_time = Time.optimum() * falling_eval * stability * instability;
+			if (Time.elapsed() > total_time) {
+				// While pondering, keep searching until ponderhit or stop
+				if (!Threads.ponder) break;
+				Threads.stopOnPonderhit = true;
+			}
+		}
+		prev_iter_val = best_val;
+	}
+
+	if (th.id == 0) {
+		// UCI forbids sending bestmove while pondering or in infinite mode
+		// before the GUI says stop or ponderhit, even if the search is done.
+		Threads.wait_for_stop_or_ponderhit();
+
+		// No more progress reports once the search is over
+		Threads.timer->stop();
+
+		// Track the node budget of the game in "nodestime" mode
+		if (Time.use_nodes_time()) {
+			Time.availableNodes += int64_t(Threads.limits.inc[pos.side_to_move()])
+			                     - int64_t(Threads.nodes_searched());
+		}
+
+		if (Threads.limits.use_time_management()) {
+			sync_cout << "info string " << (Time.use_nodes_time() ? "nodes" : "time")
+					  << " used " << Time.elapsed()
+					  << " optimum " << Time.optimum()
+					  << " maximum " << Time.maximum() << sync_endl;
+		}
+
+		if (th.evalCache.enabled()) {
+			sync_cout << "info string evalcache hits " << th.evalCache.hits()
+					  << " misses " << th.evalCache.misses() << sync_endl;
+		}
+
+		if (th.rootMoves.empty()) {
+			sync_cout << "bestmove (none)" << sync_endl;
+			return;
+		}
+
+		const RootMove& best = th.rootMoves[0];
+		Value best_val = best.score != -VALUE_INFINITE ? best.score : best.previousScore;
+		if (best_val != -VALUE_INFINITE) th.previousScore = best_val;
+
+		// The expected reply is the next move of the PV
+		Move ponder = ponder_move(pos, best);
+
+		sync_cout << "bestmove " << move_to_str(best.pv[0]);
+		if (ponder != MOVE_NONE) std::cout << " ponder " << move_to_str(ponder);
+		std::cout << sync_endl;
+	}
+}
@@ -1,7 +1,51 @@
 #ifndef SEARCH_H_INCLUDED
 #define SEARCH_H_INCLUDED
 
-#include "thread.h"
+#include "history.h"
+#include "types.h"
+#include <vector>
+
+class Thread;
+struct Option;
+
+namespace Search {
+	// Initialize the reduction and pruning tables from the tuning options
+	void init();
+	void on_param_change(const Option& op);
+}
+
+// Stack keeps the information of the nodes on the path from the root to
+// the current node, one entry per ply. Children access their parent entry
+// through (ss - 1).
+struct Stack {
+	Move* pv;
+	int ply;
+	Move currentMove;
+	Value staticEval; // VALUE_NONE when in check
+	PieceToHistory* continuationHistory; // of currentMove
+	Move excludedMove; // skipped by the singular extension search
+};
+
+// RootMove is a legal move at the root with its score and PV from the last
+// iteration. Moves are sorted by score after every iteration, so the best
+// move is always in front and is searched first in the next iteration.
+struct RootMove {
+	explicit RootMove(Move m) : pv(1, m) {}
+
+	bool operator==(Move m) const { return pv[0] == m; }
+	// Sort in descending order: moves not searched in an interrupted
+	// iteration keep -VALUE_INFINITE and are sorted by their previous score
+	bool operator<(const RootMove& m) const {
+		return m.score != score ? m.score < score
+		                        : m.previousScore < previousScore;
+	}
+
+	Value score = -VALUE_INFINITE;
+	Value previousScore = -VALUE_INFINITE;
+	std::vector<Move> pv;
+};
+
+typedef std::vector<RootMove> RootMoves;
 
 void search_root(Thread& th);
 
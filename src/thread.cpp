@@ -1,12 +1,20 @@
 #include "thread.h"
 #include "search.h"
+#include "timeman.h"
+#include "transposition.h"
+#include "uci.h"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 
 ThreadPool Threads;
 
-Thread::Thread(size_t id) : id(id), exit(false), searching(false) {
+Thread::Thread(size_t id) : id(id), nodes(0), rootDepth(0), currMove(MOVE_NONE),
+	currMoveNumber(0), previousScore(VALUE_INFINITE), bestMoveChanges(0),
+	exit(false), searching(false) {
 	states = std::unique_ptr<std::deque<StateInfo>>(new std::deque<StateInfo>);
+	clear_heuristics();
 
 	stdThread = std::thread(&Thread::idle_loop, this);
 }
@@ -30,6 +38,7 @@ void Thread::idle_loop() {
 		search_root(*this);
 
 		searching = false;
+		cv.notify_all();
 		// In Lazy SMP, helper threads just stop and wait when done
 	}
 }
@@ -38,36 +47,167 @@ void Thread::start_searching() {
 	std::lock_guard<std::mutex> lk(mutex);
 	searching = true;
 	nodes = 0;
-	cv.notify_one();
+	rootDepth = 0;
+	currMove = MOVE_NONE;
+	currMoveNumber = 0;
+	evalCache.reset_stats();
+	lazyStats.reset();
+	cv.notify_all();
 }
 
 void Thread::wait_for_search_finished() {
-	// For Thread 0 (Main), we just block until logic says stop
-	// For now, this function is mostly for joining helpers later
-	while (searching) {
-		std::this_thread::yield();
-	}
+	std::unique_lock<std::mutex> lk(mutex);
+	cv.wait(lk, [&]{ return !searching; });
 }
 
 void Thread::clear_heuristics() {
 	memset(killers, 0, sizeof(killers));
-	memset(history, 0, sizeof(history));
+	memset(mainHistory, 0, sizeof(mainHistory));
+	memset(counterMoves, 0, sizeof(counterMoves));
+	memset(continuationHistory, 0, sizeof(continuationHistory));
+	memset(captureHistory, 0, sizeof(captureHistory));
+}
+
+void Thread::age_heuristics() {
+	// Killers are tied to the plies of the last search, drop them
+	memset(killers, 0, sizeof(killers));
+	age_history(mainHistory, 1, 2);
+	age_history(continuationHistory, 1, 2);
+	age_history(captureHistory, 1, 2);
+}
+
+// Interval between two progress reports, in milliseconds
+constexpr TimePoint ReportInterval = 1000;
+
+TimerThread::TimerThread() : exit(false), active(false), woken(false), generation(0) {
+	stdThread = std::thread(&TimerThread::idle_loop, this);
+}
+
+void TimerThread::idle_loop() {
+	std::unique_lock<std::mutex> lk(mutex);
+	while (true) {
+		cv.wait(lk, [&]{ return active || exit; });
+
+		if (exit) return;
+
+		TimePoint deadline = 0, next_report = 0;
+		uint64_t seen = generation - 1;
+		while (active && !exit) {
+			// A new search may have started since the last wakeup, without
+			// the timer seeing it stopped: take its deadline. In "nodestime"
+			// mode the deadline is a node count, checked by the search.
+			if (seen != generation) {
+				seen = generation;
+				deadline = Time.use_nodes_time() ? INT64_MAX : Time.maximum();
+				next_report = ReportInterval;
+			}
+
+			TimePoint elapsed = Time.elapsed_time();
+
+			if (!Threads.ponder && elapsed >= deadline) {
+				Threads.stop();
+			}
+
+			if (elapsed >= next_report) {
+				report();
+				next_report = (elapsed / ReportInterval + 1) * ReportInterval;
+			}
+
+			// Sleep until the deadline or the next report, or until woken up
+			TimePoint wake = std::min(deadline, next_report);
+			if (Threads.stop_search || Threads.ponder) wake = next_report;
+			cv.wait_for(lk, std::chrono::milliseconds(std::max(wake - elapsed, TimePoint(1))),
+				[&]{ return !active || exit || woken || seen != generation; });
+			woken = false;
+		}
+	}
+}
+
+void TimerThread::start() {
+	std::lock_guard<std::mutex> lk(mutex);
+	active = true;
+	++generation;
+	cv.notify_one();
+}
+
+void TimerThread::wake_up() {
+	std::lock_guard<std::mutex> lk(mutex);
+	woken = true;
+	cv.notify_one();
+}
+
+void TimerThread::stop() {
+	std::lock_guard<std::mutex> lk(mutex);
+	active = false;
+	cv.notify_one();
+}
+
+void TimerThread::report() {
+	Thread* mainThread = Threads.main();
+	TimePoint elapsed = std::max(Time.elapsed_time(), TimePoint(1));
+	uint64_t nodes = Threads.nodes_searched();
+
+	sync_cout << "info nodes " << nodes
+			  << " nps " << nodes * 1000 / elapsed
+			  << " hashfull " << ttable.hashfull()
+			  << " time " << elapsed << sync_endl;
+
+	Move m = Move(mainThread->currMove.load());
+	if (m != MOVE_NONE) {
+		sync_cout << "info depth " << mainThread->rootDepth
+				  << " currmove " << move_to_str(m)
+				  << " currmovenumber " << mainThread->currMoveNumber << sync_endl;
+	}
 }
 
 void ThreadPool::init() {
 	// Create Main Thread (ID 0) - Wrapper for main execution
 	threads.push_back(new Thread(0));
 
+	timer = new TimerThread();
+
 	// Future: Add `threads.push_back(new Thread(i))` loop here for Multithreading
 }
 
 void ThreadPool::stop() {
+	std::lock_guard<std::mutex> lk(mutex);
 	stop_search = true;
+	cv.notify_all();
+}
+
+void ThreadPool::ponderhit() {
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		ponder = false;
+		if (stopOnPonderhit) stop_search = true;
+		cv.notify_all();
+	}
+	timer->wake_up();
+}
+
+void ThreadPool::wait_for_stop_or_ponderhit() {
+	std::unique_lock<std::mutex> lk(mutex);
+	cv.wait(lk, [&]{ return stop_search || !(ponder || limits.infinite); });
+}
+
+uint64_t ThreadPool::nodes_searched() const {
+	uint64_t sum = 0;
+	for (Thread* th : threads) {
+		sum += th->nodes.load(std::memory_order_relaxed);
+	}
+	return sum;
 }
 
 void ThreadPool::start_thinking(Position& pos, StateListPtr& states, const SearchLimits& limits) {
+	// A "go" right after "stop" must not restart the search being stopped,
+	// nor change its time limits or node budget while it still uses them
+	main()->wait_for_search_finished();
+
 	this->limits = limits;
+	Time.init(this->limits, pos.side_to_move(), pos.game_ply());
 	stop_search = false;
+	ponder = limits.ponder;
+	stopOnPonderhit = false;
 
 	Thread* mainThread = threads[0];
 
@@ -81,6 +221,9 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states, const Searc
 		prevPtr = &mainThread->states->back();
 	}
 	mainThread->pos.set_state_pointer(mainThread->states->back());
+	mainThread->pos.set_thread(mainThread);
 
+	// Start the timer first so that it can never miss the end of a search
+	timer->start();
 	mainThread->start_searching();
 }
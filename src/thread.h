@@ -1,7 +1,12 @@
 #ifndef THREAD_H_INCLUDED
 #define THREAD_H_INCLUDED
 
+#include "evaluation.h"
+#include "history.h"
+#include "material.h"
+#include "pawns.h"
 #include "position.h"
+#include "search.h"
 #include "types.h"
 #include <atomic>
 #include <condition_variable>
@@ -15,11 +20,16 @@ struct SearchLimits {
 	uint64_t movestogo;
 	uint64_t move_time;
 	int depth;
-	int nodes;
+	uint64_t nodes;
 	int mate;
+	int npmsec; // nodes per millisecond in "nodestime" mode, 0 if disabled
 	bool infinite;
+	bool ponder;
 	uint64_t start_time;
-	uint64_t allocated_time;
+
+	bool use_time_management() const {
+		return time[WHITE] || time[BLACK];
+	}
 };
 
 class Thread {
@@ -36,20 +46,43 @@ public:
 	// Wait for this specific thread to finish
 	void wait_for_search_finished();
 
+	// Reset all move ordering statistics, on "ucinewgame"
 	void clear_heuristics();
 
+	// Keep the statistics of the previous search, but with less weight
+	void age_heuristics();
+
 	// Internal ID
 	size_t id;
 
 	Position pos;
 	StateListPtr states; 
+	RootMoves rootMoves;
 
-	// Search statistics
-	uint64_t nodes;
+	// Search statistics, read by the timer thread while searching
+	std::atomic<uint64_t> nodes;
+	std::atomic<int> rootDepth;
+	std::atomic<int> currMove;
+	std::atomic<int> currMoveNumber;
+
+	// Time management state kept across moves (main thread only)
+	Value previousScore;
+	double bestMoveChanges;
 
 	// Killer moves: [Ply][Slot] (2 slots per ply is standard)
 	Move killers[MAX_PLY][2];
-	int history[PIECE_NB][SQ_NB];
+
+	// Quiet move statistics, kept from one search to the next
+	ButterflyHistory mainHistory;
+	CounterMoveHistory counterMoves;
+	ContinuationHistory continuationHistory;
+	CapturePieceToHistory captureHistory;
+
+	// Evaluation caches
+	Pawns::Table pawnsTable;
+	Material::Table materialTable;
+	EvalCache evalCache;
+	LazyEvalStats lazyStats;
 
 	// Threading primitives
 	std::thread stdThread;
@@ -59,6 +92,35 @@ public:
 	bool searching;
 };
 
+// TimerThread sleeps until the search deadline or the next reporting tick,
+// whichever comes first. It raises the stop flag once the maximum time is
+// used and prints periodic progress, so searchers never read the clock and
+// only have to poll an atomic flag.
+class TimerThread {
+public:
+	TimerThread();
+
+	void idle_loop();
+
+	// Called when a search starts and when it finishes
+	void start();
+	void stop();
+
+	// Re-evaluate the deadline now, e.g. after a ponderhit
+	void wake_up();
+
+private:
+	void report();
+
+	std::thread stdThread;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool exit;
+	bool active;
+	bool woken;
+	uint64_t generation; // of the current search, counted by start()
+};
+
 class ThreadPool {
 public:
 	void init();
@@ -67,12 +129,34 @@ public:
 	// Stop all threads (set flag to true)
 	void stop(); 
 
+	// The opponent played the expected move: continue as a normal search
+	void ponderhit();
+
+	// Block until "stop", or "ponderhit" when not in infinite mode: UCI
+	// forbids sending bestmove before, even if the search is done
+	void wait_for_stop_or_ponderhit();
+
+	// Sum of the nodes searched by all threads
+	uint64_t nodes_searched() const;
+
 	// Contains all worker threads
 	std::vector<Thread*> threads;
 
+	// Enforces the time limit and reports progress
+	TimerThread* timer;
+
 	// Global stop flag (atomic for thread safety)
 	std::atomic<bool> stop_search;
 
+	// Pondering: no time limits apply until ponderhit. When the search
+	// would have stopped during pondering, it stops at ponderhit instead.
+	std::atomic<bool> ponder;
+	std::atomic<bool> stopOnPonderhit;
+
+	// Signal "stop" and "ponderhit" to wait_for_stop_or_ponderhit()
+	std::mutex mutex;
+	std::condition_variable cv;
+
 	// Shared limits
 	SearchLimits limits;
 
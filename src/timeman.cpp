@@ -0,0 +1,79 @@
+#include "timeman.h"
+#include "option.h"
+#include "thread.h"
+#include "types.h"
+#include <algorithm>
+#include <cmath>
+
+TimeManager Time;
+
+TimePoint TimeManager::elapsed() const {
+	return npmsec ? TimePoint(Threads.nodes_searched()) : elapsed_time();
+}
+
+void TimeManager::init(SearchLimits& limits, Color us, int ply) {
+	startTime = TimePoint(limits.start_time);
+	npmsec = 0;
+
+	// Analysis: think until told to stop
+	if (limits.infinite) {
+		optimumTime = maximumTime = INT64_MAX;
+		return;
+	}
+
+	// Fixed time per move: stop exactly when the time is up
+	if (limits.move_time != 0) {
+		optimumTime = maximumTime = TimePoint(limits.move_time);
+		return;
+	}
+
+	// No clock: analysis or depth limited search, never stop on time
+	if (!limits.use_time_management()) {
+		optimumTime = maximumTime = INT64_MAX;
+		return;
+	}
+
+	// Convert the clock into nodes. The budget is set on the first move of
+	// the game and then tracks the nodes actually used, ignoring the GUI clock.
+	TimePoint overhead = get_option_int("Move Overhead");
+	if (get_option_int("nodestime")) {
+		npmsec = get_option_int("nodestime");
+		if (availableNodes == 0) availableNodes = int64_t(npmsec) * limits.time[us];
+		limits.time[us] = uint64_t(std::max(availableNodes, int64_t(1)));
+		limits.inc[us] *= npmsec;
+		limits.npmsec = npmsec;
+		overhead = 0;
+	}
+
+	TimePoint time = TimePoint(limits.time[us]);
+	TimePoint inc = TimePoint(limits.inc[us]);
+
+	// Plan for at most 50 moves even in sudden death, and keep a safety
+	// margin of the move overhead for every move we plan for.
+	int mtg = limits.movestogo ? std::min(int(limits.movestogo), 50) : 50;
+	TimePoint timeLeft = std::max(TimePoint(1),
+		time + inc * (mtg - 1) - overhead * (2 + mtg));
+
+	double optScale, maxScale;
+	if (limits.movestogo == 0) {
+		// Sudden death or increment: spend a bit more as the game goes on
+		optScale = std::min(0.0084 + std::pow(ply + 3.0, 0.5) * 0.0042,
+		                    0.2 * time / double(timeLeft));
+		maxScale = std::min(7.0, 4.0 + ply / 12.0);
+	} else {
+		// x moves in y seconds: share the clock between the remaining moves
+		optScale = std::min((0.88 + ply / 116.4) / mtg,
+		                    0.88 * time / double(timeLeft));
+		maxScale = std::min(6.3, 1.5 + 0.11 * mtg);
+	}
+
+	optimumTime = TimePoint(optScale * timeLeft);
+	maximumTime = TimePoint(std::min(0.8 * time - overhead, maxScale * optimumTime));
+	maximumTime = std::max(maximumTime, TimePoint(1));
+	optimumTime = std::max(std::min(optimumTime, maximumTime), TimePoint(1));
+
+	// The hard limit in nodes is enforced by the search, like "go nodes"
+	if (npmsec && (limits.nodes == 0 || uint64_t(maximumTime) < limits.nodes)) {
+		limits.nodes = uint64_t(maximumTime);
+	}
+}
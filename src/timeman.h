@@ -0,0 +1,52 @@
+#ifndef TIMEMAN_H_INCLUDED
+#define TIMEMAN_H_INCLUDED
+
+#include "thread.h"
+#include "types.h"
+#include <chrono>
+#include <cstdint>
+
+typedef int64_t TimePoint; // milliseconds
+
+inline TimePoint now() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// TimeManager computes the optimum and maximum thinking time of a move from
+// the remaining clock, the increment and the number of moves to the next
+// time control. The search stops between iterations once the optimum time
+// (scaled by the score trend and best move stability) is used, and never
+// thinks longer than the maximum time.
+//
+// In "nodestime" mode the clock is converted into a node budget and all the
+// times above are counted in nodes instead of milliseconds, which makes
+// timed games reproducible on any hardware.
+class TimeManager {
+public:
+	void init(SearchLimits& limits, Color us, int ply);
+
+	TimePoint optimum() const { return optimumTime; }
+	TimePoint maximum() const { return maximumTime; }
+
+	// Time used by this move, in nodes when "nodestime" is enabled
+	TimePoint elapsed() const;
+
+	// Wall clock time used by this move
+	TimePoint elapsed_time() const { return now() - startTime; }
+
+	bool use_nodes_time() const { return npmsec != 0; }
+
+	// Node budget left for the game in "nodestime" mode (0 = not started)
+	int64_t availableNodes = 0;
+
+private:
+	int npmsec;
+	TimePoint startTime;
+	TimePoint optimumTime;
+	TimePoint maximumTime;
+};
+
+extern TimeManager Time;
+
+#endif
@@ -0,0 +1,458 @@
+#include "tune.h"
+#include "evaluation.h"
+#include "position.h"
+#include "types.h"
+#include "weights.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace Tune {
+
+int Coefficients[PARAM_NB][COLOR_NB];
+
+namespace {
+
+// Weights of the scalar parameters, in the order of Param and of weights.h
+struct Scalar {
+	Param param;
+	const char* name;
+	Score value;
+};
+
+const Scalar Scalars[] = {
+	{ ROOK_OPEN_FILE, "BonusRookOpenFile", BonusRookOpenFile },
+	{ ROOK_SEMI_OPEN_FILE, "BonusRookSemiOpenFile", BonusRookSemiOpenFile },
+	{ KNIGHT_OUTPOST, "BonusKnightOutpost", BonusKnightOutpost },
+	{ ROOK_ON_7TH, "BonusRookOn7th", BonusRookOn7th },
+	{ KNIGHT_MOBILITY, "MobilityKnight", MobilityKnight },
+	{ BISHOP_MOBILITY, "MobilityBishop", MobilityBishop },
+	{ ROOK_MOBILITY, "MobilityRook", MobilityRook },
+	{ QUEEN_MOBILITY, "MobilityQueen", MobilityQueen },
+	{ KNIGHT_ON_RIM, "PenaltyKnightOnRim", PenaltyKnightOnRim },
+	{ EARLY_QUEEN, "PenaltyEarlyQueen", PenaltyEarlyQueen },
+	{ ISOLATED, "ScoreIsolated", ScoreIsolated },
+	{ DOUBLED, "ScoreDoubled", ScoreDoubled },
+	{ BACKWARD, "ScoreBackward", ScoreBackward },
+	{ KING_ON_CASTLED_FILE, "BonusKingSafety", BonusKingSafety },
+	{ PAWN_SHIELD, "ScorePawnShield", ScorePawnShield },
+	{ NO_PAWN_SHIELD, "ScoreNoPawnShield", ScoreNoPawnShield },
+	{ BISHOP_PAIR, "BonusBishopPair", BonusBishopPair },
+};
+
+const char* PieceNames[] = { "", "", "Knight", "Bishop", "Rook", "Queen", "King" };
+
+// Expected score of White for an evaluation
+double sigmoid(double K, double eval) {
+	return 1.0 / (1.0 + std::pow(10.0, -K * eval / 400.0));
+}
+
+// Run f(begin, end, thread index) over the entries, split between threads
+template<typename F>
+void parallel_for(size_t size, int threads, F f) {
+	std::vector<std::thread> workers;
+	size_t chunk = (size + threads - 1) / threads;
+	for (int t = 0; t < threads; ++t) {
+		size_t begin = std::min(size, t * chunk);
+		size_t end = std::min(size, begin + chunk);
+		workers.emplace_back(f, begin, end, t);
+	}
+	for (std::thread& th : workers) th.join();
+}
+
+// Move of a position from its SAN, or MOVE_NONE
+Move san_to_move(Position& pos, std::string san) {
+	while (!san.empty() && std::strchr("+#!?", san.back())) san.pop_back();
+
+	svec<Move> moves;
+	pos.generate_moves(moves);
+
+	if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+		File kingTo = san.size() == 3 ? FILE_G : FILE_C;
+		for (int i = 0; i < moves.size(); ++i) {
+			if (type_of(moves[i]) == CASTLING && get_file(to_sq(moves[i])) == kingTo) return moves[i];
+		}
+		return MOVE_NONE;
+	}
+
+	// [piece][from file][from rank][x]<to>[=promotion]
+	PieceType promotion = NO_PIECE_TYPE;
+	size_t eq = san.find('=');
+	if (eq != std::string::npos || (san.size() > 2 && std::strchr("NBRQ", san.back()))) {
+		const char* p = std::strchr(" PNBRQ", san.back());
+		promotion = p ? PieceType(p - " PNBRQ") : NO_PIECE_TYPE;
+		san.erase(eq != std::string::npos ? eq : san.size() - 1);
+	}
+	if (san.size() < 2) return MOVE_NONE;
+
+	PieceType pt = PAWN;
+	size_t first = 0;
+	if (const char* p = std::strchr("NBRQK", san[0])) {
+		pt = PieceType(KNIGHT + (p - "NBRQK"));
+		first = 1;
+	}
+	std::string to = san.substr(san.size() - 2);
+	std::string from;
+	for (size_t i = first; i + 2 < san.size(); ++i) {
+		if (san[i] != 'x') from += san[i];
+	}
+
+	Move found = MOVE_NONE;
+	for (int i = 0; i < moves.size(); ++i) {
+		Move m = moves[i];
+		Square fr = from_sq(m);
+		if (type_of(m) == CASTLING
+		    || get_piece_type(pos.piece_on(fr)) != pt
+		    || square_to_str(to_sq(m)) != to
+		    || (type_of(m) == PROMOTION ? promotion_type(m) : NO_PIECE_TYPE) != promotion) {
+			continue;
+		}
+		bool matches = true;
+		for (char c : from) {
+			matches &= c >= 'a' && c <= 'h' ? get_file(fr) == File(c - 'a') : get_rank(fr) == Rank(c - '1');
+		}
+		if (matches) {
+			if (found != MOVE_NONE) return MOVE_NONE; // ambiguous
+			found = m;
+		}
+	}
+	return found;
+}
+
+// The quiet positions of one game. The positions of the opening, in check,
+// or before a capture or a promotion are skipped.
+struct Game {
+	std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	std::vector<std::string> moves;
+	float result = -1;
+};
+
+constexpr int SkippedPlies = 8;
+
+bool add_game(const Game& game, DataSet& data) {
+	if (game.result < 0) return false;
+
+	std::deque<StateInfo> states(1);
+	Position pos;
+	pos.set(game.fen, states.back());
+
+	for (size_t ply = 0; ply < game.moves.size(); ++ply) {
+		Move m = san_to_move(pos, game.moves[ply]);
+		if (m == MOVE_NONE) return false;
+
+		if (ply >= SkippedPlies && !pos.is_in_check() && type_of(m) == NORMAL
+		    && pos.piece_on(to_sq(m)) == NO_PIECE) {
+			add_position(pos, game.result, data);
+		}
+		states.emplace_back();
+		pos.do_move(m, states.back());
+	}
+	return true;
+}
+
+} // namespace
+
+int read_pgn(std::istream& pgn, DataSet& data) {
+	Game game;
+	int games = 0;
+	bool inMoves = false;
+	char c;
+
+	auto finish = [&]() {
+		games += add_game(game, data);
+		game = Game();
+		inMoves = false;
+	};
+
+	while (pgn.get(c)) {
+		if (c == '[') {
+			// A tag pair, [Name "Value"]
+			if (inMoves) finish();
+			std::string tag;
+			std::getline(pgn, tag, ']');
+			std::istringstream ts(tag);
+			std::string name, value;
+			ts >> name;
+			std::getline(ts >> std::ws, value);
+			if (value.size() >= 2) value = value.substr(1, value.size() - 2);
+			if (name == "FEN") game.fen = value;
+			if (name == "Result") {
+				game.result = value == "1-0" ? 1.0f : value == "0-1" ? 0.0f : value == "1/2-1/2" ? 0.5f : -1.0f;
+			}
+		}
+		else if (c == '{') {
+			std::string comment;
+			std::getline(pgn, comment, '}');
+		}
+		else if (c == ';') {
+			std::string comment;
+			std::getline(pgn, comment);
+		}
+		else if (c == '(') {
+			// Variations, possibly nested
+			for (int depth = 1; depth > 0 && pgn.get(c); ) {
+				depth += (c == '(') - (c == ')');
+			}
+		}
+		else if (!std::isspace(static_cast<unsigned char>(c))) {
+			std::string token(1, c);
+			while (pgn.peek() != EOF && !std::isspace(pgn.peek()) && !std::strchr("{;()[", pgn.peek())) {
+				token += char(pgn.get());
+			}
+			inMoves = true;
+			if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+				finish();
+				continue;
+			}
+			// Move numbers, "12." or "12...", possibly glued to the move
+			size_t i = 0;
+			while (i < token.size() && (std::isdigit(static_cast<unsigned char>(token[i])) || token[i] == '.')) ++i;
+			if (i > 0 && token.find('.') != std::string::npos) token = token.substr(i);
+			if (!token.empty() && token[0] != '$') game.moves.push_back(token);
+		}
+	}
+	if (inMoves) finish();
+	return games;
+}
+
+bool add_position(const Position& pos, float result, DataSet& data) {
+	static const Weights compiled;
+	Score score;
+	int phase, scaleFactor;
+	if (!Eval::linearize(pos, score, phase, scaleFactor)) return false;
+
+	Entry e;
+	e.begin = uint32_t(data.coefficients.size());
+	e.size = 0;
+	e.phase = uint8_t(phase);
+	e.scaleFactor = uint8_t(scaleFactor);
+	e.result = result;
+
+	// The rest of the evaluation: piece values, king danger
+	int mg = mg_value(score), eg = eg_value(score);
+	for (int p = 0; p < PARAM_NB; ++p) {
+		int v = Coefficients[p][WHITE] - Coefficients[p][BLACK];
+		if (v) {
+			data.coefficients.push_back({ uint16_t(p), int16_t(v) });
+			++e.size;
+			mg -= v * int(compiled.mg[p]);
+			eg -= v * int(compiled.eg[p]);
+		}
+	}
+	e.offsetMg = mg;
+	e.offsetEg = eg;
+	data.entries.push_back(e);
+	return true;
+}
+
+Weights::Weights() {
+	auto set = [&](int p, Score s) {
+		mg[p] = mg_value(s);
+		eg[p] = eg_value(s);
+	};
+
+	for (const Scalar& s : Scalars) set(s.param, s.value);
+	for (Rank r = RANK_1; r <= RANK_8; ++r) {
+		set(PASSED_PAWN + r, BonusPassedPawn[r]);
+	}
+	for (PieceType pt = KNIGHT; pt <= KING; ++pt) {
+		for (Square s = SQ_A1; s <= SQ_H8; ++s) {
+			if (get_file(s) <= FILE_D) {
+				set(psq_param(pt, s), PSQT::Bonus[pt][get_rank(s)][get_file(s)]);
+			}
+		}
+	}
+	for (Square s = SQ_A1; s <= SQ_H8; ++s) {
+		set(psq_param(PAWN, s), PSQT::PBonus[get_rank(s)][get_file(s)]);
+	}
+}
+
+double evaluate(const DataSet& data, const Entry& e, const Weights& w) {
+	double mg = e.offsetMg, eg = e.offsetEg;
+	const Coefficient* c = &data.coefficients[e.begin];
+	for (int i = 0; i < e.size; ++i) {
+		mg += c[i].value * w.mg[c[i].index];
+		eg += c[i].value * w.eg[c[i].index];
+	}
+	eg = eg * e.scaleFactor / SCALE_FACTOR_NORMAL;
+	return (mg * e.phase + eg * (128 - e.phase)) / 128;
+}
+
+double error(const DataSet& data, const Weights& w, double K, int threads) {
+	std::vector<double> sums(threads);
+	parallel_for(data.entries.size(), threads, [&](size_t begin, size_t end, int t) {
+		double sum = 0;
+		for (size_t i = begin; i < end; ++i) {
+			double d = data.entries[i].result - sigmoid(K, evaluate(data, data.entries[i], w));
+			sum += d * d;
+		}
+		sums[t] = sum;
+	});
+	double total = 0;
+	for (double s : sums) total += s;
+	return total / std::max(data.entries.size(), size_t(1));
+}
+
+double find_k(const DataSet& data, const Weights& w, int threads) {
+	double best = 1.0, step = 0.5, bestError = error(data, w, best, threads);
+	for (int iteration = 0; iteration < 20; ++iteration) {
+		bool improved = false;
+		for (double K : { best - step, best + step }) {
+			double e = K > 0 ? error(data, w, K, threads) : bestError;
+			if (e < bestError) {
+				bestError = e;
+				best = K;
+				improved = true;
+			}
+		}
+		if (!improved) step /= 2;
+	}
+	return best;
+}
+
+void optimize(const DataSet& data, Weights& w, double K, int epochs, int threads, int report) {
+	constexpr double Beta1 = 0.9, Beta2 = 0.999, Epsilon = 1e-8, Rate = 1.0;
+	std::vector<double> m(2 * PARAM_NB), v(2 * PARAM_NB);
+	std::vector<std::vector<double>> gradients(threads, std::vector<double>(2 * PARAM_NB));
+	const double n = double(std::max(data.entries.size(), size_t(1)));
+
+	for (int epoch = 1; epoch <= epochs; ++epoch) {
+		// Gradient of the mean squared error, by thread
+		parallel_for(data.entries.size(), threads, [&](size_t begin, size_t end, int t) {
+			std::vector<double>& g = gradients[t];
+			std::fill(g.begin(), g.end(), 0.0);
+			for (size_t i = begin; i < end; ++i) {
+				const Entry& e = data.entries[i];
+				double s = sigmoid(K, evaluate(data, e, w));
+				double d = (s - e.result) * s * (1 - s);
+				double dmg = d * e.phase / 128;
+				double deg = d * (128 - e.phase) / 128 * e.scaleFactor / SCALE_FACTOR_NORMAL;
+				const Coefficient* c = &data.coefficients[e.begin];
+				for (int j = 0; j < e.size; ++j) {
+					g[2 * c[j].index] += dmg * c[j].value;
+					g[2 * c[j].index + 1] += deg * c[j].value;
+				}
+			}
+		});
+
+		// Adam step, the constant factors of the gradient are left to the
+		// step size
+		for (int p = 0; p < 2 * PARAM_NB; ++p) {
+			double g = 0;
+			for (int t = 0; t < threads; ++t) g += gradients[t][p];
+			g /= n;
+			m[p] = Beta1 * m[p] + (1 - Beta1) * g;
+			v[p] = Beta2 * v[p] + (1 - Beta2) * g * g;
+			double mh = m[p] / (1 - std::pow(Beta1, epoch));
+			double vh = v[p] / (1 - std::pow(Beta2, epoch));
+			double& weight = p % 2 ? w.eg[p / 2] : w.mg[p / 2];
+			weight -= Rate * mh / (std::sqrt(vh) + Epsilon);
+		}
+
+		if (report && epoch % report == 0) {
+			std::cout << "epoch " << epoch << " error " << std::setprecision(8)
+			          << error(data, w, K, threads) << std::endl;
+		}
+	}
+}
+
+void write_header(std::ostream& os, const Weights& w) {
+	auto S = [&](int p) {
+		return "S(" + std::to_string(int(std::lround(w.mg[p]))) + ", "
+		     + std::to_string(int(std::lround(w.eg[p]))) + ")";
+	};
+	auto scalar = [&](const char* name) {
+		for (const Scalar& s : Scalars) {
+			if (!std::strcmp(s.name, name)) {
+				os << "constexpr Score " << name << " = " << S(s.param) << ";\n";
+			}
+		}
+	};
+
+	os << "// Evaluation weights, as (middlegame, endgame) pairs. This file is written\n"
+	      "// by the tuner (\"tune\", see tune.cpp): keep its layout when editing it.\n"
+	      "\n"
+	      "#ifndef WEIGHTS_H_INCLUDED\n"
+	      "#define WEIGHTS_H_INCLUDED\n"
+	      "\n"
+	      "#include \"types.h\"\n"
+	      "\n"
+	      "#define S(mg, eg) make_score(mg, eg)\n"
+	      "\n"
+	      "// Piece activity\n";
+	scalar("BonusRookOpenFile");
+	scalar("BonusRookSemiOpenFile");
+	scalar("BonusKnightOutpost");
+	scalar("BonusRookOn7th");
+	os << "\n// Mobility, by attacked square of the mobility area\n";
+	scalar("MobilityKnight");
+	scalar("MobilityBishop");
+	scalar("MobilityRook");
+	scalar("MobilityQueen");
+	os << "\n// Penalties, subtracted from the score\n";
+	scalar("PenaltyKnightOnRim");
+	scalar("PenaltyEarlyQueen");
+	os << "\n// Pawn structure\n";
+	scalar("ScoreIsolated");
+	scalar("ScoreDoubled");
+	scalar("ScoreBackward");
+	os << "\n// Passed pawns, by relative rank\n"
+	      "constexpr Score BonusPassedPawn[RANK_NB] = {\n\t";
+	for (Rank r = RANK_1; r <= RANK_8; ++r) {
+		os << S(PASSED_PAWN + r) << (r < RANK_8 ? ", " : "\n");
+	}
+	os << "};\n"
+	      "\n"
+	      "// King shelter: king on a castled file of its back rank, and pawns in\n"
+	      "// front of it\n";
+	scalar("BonusKingSafety");
+	scalar("ScorePawnShield");
+	scalar("ScoreNoPawnShield");
+	os << "\n// Material\n";
+	scalar("BonusBishopPair");
+
+	os << "\n"
+	      "namespace PSQT {\n"
+	      "\n"
+	      "// Bonus[PieceType][Rank][File] for files A..D, mirrored on files E..H, and\n"
+	      "// PBonus[Rank][File] for the pawns, from White's point of view\n"
+	      "constexpr Score Bonus[][RANK_NB][FILE_NB / 2] = {\n"
+	      "\t{ },\n"
+	      "\t{ },\n";
+	for (PieceType pt = KNIGHT; pt <= KING; ++pt) {
+		os << "\t{ // " << PieceNames[pt] << "\n";
+		for (Rank r = RANK_1; r <= RANK_8; ++r) {
+			os << "\t\t{ ";
+			for (File f = FILE_A; f <= FILE_D; ++f) {
+				os << S(psq_param(pt, make_square(f, r))) << (f < FILE_D ? ", " : " }");
+			}
+			os << (r < RANK_8 ? ",\n" : "\n");
+		}
+		os << (pt < KING ? "\t},\n" : "\t}\n");
+	}
+	os << "};\n"
+	      "\n"
+	      "constexpr Score PBonus[RANK_NB][FILE_NB] = {\n";
+	for (Rank r = RANK_1; r <= RANK_8; ++r) {
+		os << "\t{ ";
+		for (File f = FILE_A; f <= FILE_H; ++f) {
+			os << S(psq_param(PAWN, make_square(f, r))) << (f < FILE_H ? ", " : " }");
+		}
+		os << (r < RANK_8 ? ",\n" : "\n");
+	}
+	os << "};\n"
+	      "\n"
+	      "} // namespace PSQT\n"
+	      "\n"
+	      "#undef S\n"
+	      "\n"
+	      "#endif\n";
+}
+
+} // namespace Tune
@@ -0,0 +1,107 @@
+#ifndef TUNE_H_INCLUDED
+#define TUNE_H_INCLUDED
+
+#include "types.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Position;
+
+// Instances of the evaluation: the one of the search, and the ones of the
+// "eval" and "evalbench" commands and of the tuner, whose hooks are
+// compiled out of the first.
+enum Tracing { NO_TRACE, TRACE, PROFILE };
+
+namespace Tune {
+
+// Index of each weight of weights.h in the linear decomposition of the
+// evaluation. Arrays take one index per element.
+enum Param : int {
+	ROOK_OPEN_FILE, ROOK_SEMI_OPEN_FILE, KNIGHT_OUTPOST, ROOK_ON_7TH,
+	KNIGHT_MOBILITY, BISHOP_MOBILITY, ROOK_MOBILITY, QUEEN_MOBILITY,
+	KNIGHT_ON_RIM, EARLY_QUEEN,
+	ISOLATED, DOUBLED, BACKWARD,
+	PASSED_PAWN, // by relative rank
+	KING_ON_CASTLED_FILE = PASSED_PAWN + RANK_NB, PAWN_SHIELD, NO_PAWN_SHIELD,
+	BISHOP_PAIR,
+	PSQ_PIECE, // [KNIGHT..KING][rank][queenside file]
+	PSQ_PAWN = PSQ_PIECE + 5 * int(SQ_NB) / 2, // [rank][file]
+	PARAM_NB = PSQ_PAWN + SQ_NB
+};
+
+// Piece-square weight of a piece on s, from the point of view of its color
+constexpr Param psq_param(PieceType pt, Square s) {
+	return pt == PAWN ? Param(PSQ_PAWN + s)
+	                  : Param(PSQ_PIECE + (pt - KNIGHT) * int(SQ_NB) / 2
+	                          + (s >> 3) * int(FILE_NB) / 2 + ((s & 7) < FILE_E ? (s & 7) : FILE_H - (s & 7)));
+}
+
+// How many times each weight is counted for each color by the last traced
+// evaluation: the evaluation is the sum of the weights times the white
+// minus the black counts, plus the terms which are not linear.
+extern int Coefficients[PARAM_NB][COLOR_NB];
+
+inline void add(Param p, Color c, int n = 1) {
+	Coefficients[p][c] += n;
+}
+
+// A position of a game, as the non-zero coefficients of its evaluation,
+// the rest of the evaluation, and the result of the game
+struct Coefficient {
+	uint16_t index;
+	int16_t value;
+};
+
+struct Entry {
+	uint32_t begin; // in the coefficient array of the data set
+	uint16_t size;
+	uint8_t phase;
+	uint8_t scaleFactor;
+	int32_t offsetMg, offsetEg;
+	float result; // for White, 1 for a win
+};
+
+struct DataSet {
+	std::vector<Entry> entries;
+	std::vector<Coefficient> coefficients;
+};
+
+// Add the quiet positions of the games of a PGN file to the data set.
+// Returns the number of games read, games with an unknown result or an
+// illegal move are skipped.
+int read_pgn(std::istream& pgn, DataSet& data);
+
+// Add a position labelled with a result. Returns false, and adds nothing,
+// when the evaluation is not linear, e.g. with a specialized endgame.
+bool add_position(const Position& pos, float result, DataSet& data);
+
+// The weights of weights.h, as (middlegame, endgame) pairs
+struct Weights {
+	Weights(); // the compiled-in weights
+	double mg[PARAM_NB];
+	double eg[PARAM_NB];
+};
+
+// Evaluation of an entry with the weights, from White's point of view
+double evaluate(const DataSet& data, const Entry& e, const Weights& w);
+
+// Mean squared error of the predicted results, with the logistic of
+// K * eval / 400 as the expected score
+double error(const DataSet& data, const Weights& w, double K, int threads);
+
+// The scaling constant K with the least error
+double find_k(const DataSet& data, const Weights& w, int threads);
+
+// Fit the weights with Adam gradient descent, printing the error every
+// report epochs
+void optimize(const DataSet& data, Weights& w, double K, int epochs, int threads, int report);
+
+// Write weights.h with the weights, rounded
+void write_header(std::ostream& os, const Weights& w);
+
+} // namespace Tune
+
+#endif
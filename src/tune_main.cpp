@@ -0,0 +1,65 @@
+#include "bitboard.h"
+#include "endgame.h"
+#include "evaluation.h"
+#include "position.h"
+#include "tune.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// tune [-o <weights.h>] [-e <epochs>] [-t <threads>] <pgn>...
+//
+// Fit the weights of weights.h to the results of the games of the PGN
+// files, and write the fitted weights to a new weights.h.
+int main(int argc, char **argv)
+{
+	bitboard::init();
+	PSQT::init();
+	Position::init();
+	Endgames::init();
+
+	std::string output = "weights.h";
+	int epochs = 1000;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc) output = argv[++i];
+		else if (arg == "-e" && i + 1 < argc) epochs = std::atoi(argv[++i]);
+		else if (arg == "-t" && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+		else files.push_back(arg);
+	}
+	if (files.empty()) {
+		std::cerr << "usage: tune [-o <weights.h>] [-e <epochs>] [-t <threads>] <pgn>..." << std::endl;
+		return 1;
+	}
+
+	Tune::DataSet data;
+	for (const std::string& file : files) {
+		std::ifstream pgn(file);
+		if (!pgn) {
+			std::cerr << "Unable to open '" << file << "'" << std::endl;
+			return 1;
+		}
+		int games = Tune::read_pgn(pgn, data);
+		std::cout << file << ": " << games << " games" << std::endl;
+	}
+	std::cout << data.entries.size() << " positions, "
+	          << data.coefficients.size() << " coefficients" << std::endl;
+
+	Tune::Weights weights;
+	double K = Tune::find_k(data, weights, threads);
+	std::cout << "K " << K << " error " << Tune::error(data, weights, K, threads) << std::endl;
+
+	Tune::optimize(data, weights, K, epochs, threads, std::max(epochs / 10, 1));
+
+	std::ofstream os(output);
+	Tune::write_header(os, weights);
+	std::cout << "Weights written to " << output << std::endl;
+	return 0;
+}
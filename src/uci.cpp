@@ -1,152 +1,325 @@
-#include "uci.h"
-#include "option.h"
-#include "position.h"
-#include "sephirah.h"
-#include "thread.h"
-#include "transposition.h"
-#include "types.h"
-#include <algorithm>
-#include <cctype>
-#include <cstring>
-#include <iostream>
-#include <sstream>
-#include <string>
-
-const std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-
-namespace UCI {
-
-void uci() {
-	std::cout << "id name " SEPHIRAH_NAME " " SEPHIRAH_VERSION << std::endl;
-	std::cout << "id author " SEPHIRAH_AUTHOR << std::endl;
-	std::cout << std::endl;
-	for (const auto& [_, op] : Options) {
-		std::cout << op << std::endl;
-	}
-	std::cout << "uciok" << std::endl;
-}
-
-void ucinewgame(Position& pos, StateListPtr& dq) {
-	dq->clear();
-	dq->emplace_back();
-	pos.set(startpos, dq->back());
-
-	ttable.clear();
-
-	Threads.main()->clear_heuristics();
-}
-
-void position(std::istringstream& ss, Position& pos, StateListPtr& dq) {
-	std::string fen;
-	std::string tmp;
-	ss >> tmp;
-	if (tmp == "startpos") fen = startpos;
-	else {
-		ss >> fen;
-	}
-	dq->clear();
-	dq->emplace_back();
-	pos.set(fen, dq->back());
-
-	ss >> tmp; 
-	while (ss >> tmp) {
-		Move m = pos.string_to_move(tmp);
-		dq->emplace_back();
-		pos.do_move(m, dq->back());
-	}
-}
-
-void go(std::istringstream& ss, Position& pos, StateListPtr& dq) {
-	SearchLimits limits;
-	memset(&limits, 0, sizeof(limits));
-	
-	std::string token;
-	while (ss >> token) {
-		if (token == "wtime") ss >> limits.time[WHITE];
-		else if (token == "btime") ss >> limits.time[BLACK];
-		else if (token == "winc") ss >> limits.inc[WHITE];
-		else if (token == "binc") ss >> limits.inc[BLACK];
-		else if (token == "depth") ss >> limits.depth;
-		else if (token == "movetime") ss >> limits.move_time;
-		else if (token == "infinite") limits.infinite = true;
-	}
-
-	// Calculate time allocation
-	uint64_t t = limits.time[pos.side_to_move()];
-	uint64_t inc = limits.inc[pos.side_to_move()];
-
-	if (limits.move_time != 0) {
-		limits.allocated_time = limits.move_time;
-	} else if (t != 0) {
-		limits.allocated_time = t / 20 + inc / 2;
-		if (limits.allocated_time < 50) limits.allocated_time = 50;
-	} else {
-		limits.allocated_time = 1000000; // Infinite/Analysis
-	}
-
-	Threads.start_thinking(pos, dq, limits);
-}
-
-void setoption(std::istringstream& ss, std::string& token) {
-	std::string name;
-	ss >> token >> name;
-	while (ss >> token && token != "value")
-		name = name + " " + token;
-	if (Options.count(name) == 0) {
-		std::cout << "Invalid option '" << name << "'" << std::endl;
-		return;
-	}
-	Option& op = Options[name];
-	if (op.type != "button") {
-		ss >> token;
-		if (op.type == "spin") {
-			int value;
-			ss >> value;
-			if (op.min <= value && value <= op.max) {
-				op.value = value;
-			}
-		} else {
-			ss >> token;
-			std::transform(token.cbegin(), token.cend(), token.begin(),
-				[](unsigned char c){ return std::tolower(c); });
-			op.value = token;
-		}
-	}
-	if (op.on_change)
-		op.on_change(op);
-}
-
-int main(int argc, char **argv) {
-	Position pos;
-	StateListPtr dq(new std::deque<StateInfo>());
-
-	ucinewgame(pos, dq);
-
-	std::cout << SEPHIRAH_NAME " " SEPHIRAH_VERSION " by " SEPHIRAH_AUTHOR << std::endl;
-	while (1) {
-		std::string cmd;
-		std::getline(std::cin, cmd);
-		std::istringstream ss(cmd);
-		std::string token;
-
-		if (!(ss >> std::skipws >> token)) {
-			continue;
-		}
-
-		if (token == "uci") uci();
-		else if (token == "isready") std::cout << "readyok" << std::endl;
-		else if (token == "setoption") setoption(ss, token);
-		else if (token == "ucinewgame") ucinewgame(pos, dq);
-		else if (token == "position") position(ss, pos, dq);
-		else if (token == "go") go(ss, pos, dq);
-		else if (token == "stop") Threads.stop();
-		else if (token == "quit") {
-			Threads.stop();
-			exit(0);
-		}
-		else  std::cout << "No such command '" << token << "'" << std::endl;
-	}
-	return 0;
-}
-
-}
+#include "uci.h"
+#include "evaluation.h"
+#include "option.h"
+#include "position.h"
+#include "sephirah.h"
+#include "thread.h"
+#include "timeman.h"
+#include "transposition.h"
+#include "types.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const std::string startpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+std::ostream& operator<<(std::ostream& os, SyncCout sc) {
+	static std::mutex m;
+	if (sc == IO_LOCK) m.lock();
+	if (sc == IO_UNLOCK) m.unlock();
+	return os;
+}
+
+namespace UCI {
+
+void uci() {
+	std::cout << "id name " SEPHIRAH_NAME " " SEPHIRAH_VERSION << std::endl;
+	std::cout << "id author " SEPHIRAH_AUTHOR << std::endl;
+	std::cout << std::endl;
+	for (const auto& [_, op] : Options) {
+		std::cout << op << std::endl;
+	}
+	std::cout << "uciok" << std::endl;
+}
+
+void ucinewgame(Position& pos, StateListPtr& dq) {
+	dq->clear();
+	dq->emplace_back();
+	pos.set(startpos, dq->back());
+
+	ttable.clear();
+
+	Threads.main()->clear_heuristics();
+	Threads.main()->previousScore = VALUE_INFINITE;
+	Time.availableNodes = 0;
+}
+
+void position(std::istringstream& ss, Position& pos, StateListPtr& dq) {
+	std::string fen;
+	std::string tmp;
+	ss >> tmp;
+	if (tmp == "startpos") {
+		fen = startpos;
+		ss >> tmp; // consume "moves" if any
+	} else {
+		// the FEN string spans several tokens, up to "moves"
+		while (ss >> tmp && tmp != "moves")
+			fen += tmp + " ";
+	}
+	dq->clear();
+	dq->emplace_back();
+	pos.set(fen, dq->back());
+
+	while (ss >> tmp) {
+		Move m = pos.string_to_move(tmp);
+		dq->emplace_back();
+		pos.do_move(m, dq->back());
+	}
+}
+
+void go(std::istringstream& ss, Position& pos, StateListPtr& dq) {
+	SearchLimits limits;
+	memset(&limits, 0, sizeof(limits));
+	limits.start_time = now(); // as early as possible
+
+	std::string token;
+	while (ss >> token) {
+		if (token == "wtime") ss >> limits.time[WHITE];
+		else if (token == "btime") ss >> limits.time[BLACK];
+		else if (token == "winc") ss >> limits.inc[WHITE];
+		else if (token == "binc") ss >> limits.inc[BLACK];
+		else if (token == "movestogo") ss >> limits.movestogo;
+		else if (token == "depth") ss >> limits.depth;
+		else if (token == "nodes") ss >> limits.nodes;
+		else if (token == "mate") ss >> limits.mate;
+		else if (token == "movetime") ss >> limits.move_time;
+		else if (token == "infinite") limits.infinite = true;
+		else if (token == "ponder") limits.ponder = true;
+	}
+
+	Threads.start_thinking(pos, dq, limits);
+}
+
+// Positions searched by "bench": openings, middlegames and endgames
+const std::vector<std::string> BenchPositions = {
+	startpos,
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+	"6k1/5pp1/7p/8/3R4/6P1/5PKP/3r4 w - - 0 40",
+	"r1b2rk1/2q1bppp/p2ppn2/1p6/3BP3/1BN5/PPP2PPP/R2Q1RK1 w - - 0 13",
+	"2r3k1/1q3ppp/p3p3/1p1nP3/3P4/P4N2/1B3PPP/2RQ2K1 b - - 0 25",
+};
+
+// "bench [depth]": search the bench positions to a fixed depth and report
+// the node count and speed, with the statistics of the lazy evaluation
+void bench(std::istringstream& ss, Position& pos, StateListPtr& dq) {
+	int depth = 9;
+	ss >> depth;
+
+	Thread* th = Threads.main();
+	LazyEvalStats lazy;
+	uint64_t nodes = 0;
+	th->lazyStats.sampling = true;
+	TimePoint start = now();
+
+	for (const std::string& fen : BenchPositions) {
+		ucinewgame(pos, dq);
+		std::istringstream ps("fen " + fen);
+		position(ps, pos, dq);
+		std::istringstream gs("depth " + std::to_string(depth));
+		go(gs, pos, dq);
+		th->wait_for_search_finished();
+
+		nodes += Threads.nodes_searched();
+		lazy.evals += th->lazyStats.evals;
+		lazy.exits += th->lazyStats.exits;
+		lazy.samples += th->lazyStats.samples;
+		lazy.misjudged += th->lazyStats.misjudged;
+		lazy.totalError += th->lazyStats.totalError;
+	}
+
+	TimePoint elapsed = std::max(now() - start, TimePoint(1));
+	th->lazyStats.sampling = false;
+
+	sync_cout << "===========================" << std::endl
+	          << "Total time (ms) : " << elapsed << std::endl
+	          << "Nodes searched  : " << nodes << std::endl
+	          << "Nodes/second    : " << nodes * 1000 / elapsed << std::endl
+	          << "Lazy eval exits : " << lazy.exits << " of " << lazy.evals << " evaluations ("
+	          << (lazy.evals ? 100.0 * lazy.exits / lazy.evals : 0.0) << "%)" << std::endl
+	          << "Lazy eval error : " << (lazy.samples ? double(lazy.totalError) / lazy.samples : 0.0)
+	          << " cp on average, " << lazy.misjudged << " of " << lazy.samples
+	          << " samples misjudged" << sync_endl;
+}
+
+// "evalbench <file> [passes]": time the evaluation of the positions of an
+// EPD or FEN file
+void evalbench(std::istringstream& ss) {
+	std::string file;
+	int passes = 10;
+	ss >> file >> passes;
+
+	std::ifstream epd(file);
+	if (!epd) {
+		sync_cout << "Unable to open '" << file << "'" << sync_endl;
+		return;
+	}
+	sync_cout << Eval::profile(epd, std::max(passes, 1)) << IO_UNLOCK;
+}
+
+// "evalbatch <input> <output> [threads]": evaluate the positions of a file
+// with Eval::evaluate_batch(). The input is one FEN or EPD position per
+// line, or PackedPosition records when its name ends in ".bin". The scores
+// are written one per line, or as 16 bit integers to a ".bin" output.
+void evalbatch(std::istringstream& ss) {
+	std::string input, output;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	ss >> input >> output >> threads;
+	threads = std::max(threads, 1);
+
+	auto binary = [](const std::string& file) {
+		return file.size() > 4 && file.compare(file.size() - 4, 4, ".bin") == 0;
+	};
+
+	std::ifstream is(input, binary(input) ? std::ios::binary : std::ios::in);
+	if (!is) {
+		sync_cout << "Unable to open '" << input << "'" << sync_endl;
+		return;
+	}
+
+	std::vector<PackedPosition> positions;
+	if (binary(input)) {
+		is.seekg(0, std::ios::end);
+		positions.resize(size_t(is.tellg()) / sizeof(PackedPosition));
+		is.seekg(0);
+		is.read(reinterpret_cast<char*>(positions.data()), positions.size() * sizeof(PackedPosition));
+	} else {
+		StateInfo st;
+		Position pos;
+		std::string line;
+		while (std::getline(is, line)) {
+			if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+			pos.set(line, st);
+			positions.push_back(pos.pack());
+		}
+	}
+
+	std::vector<Value> scores(positions.size());
+	TimePoint start = now();
+	Eval::evaluate_batch(positions.data(), positions.size(), scores.data(), threads);
+	TimePoint elapsed = std::max(now() - start, TimePoint(1));
+
+	std::ofstream os(output, binary(output) ? std::ios::binary : std::ios::out);
+	if (binary(output)) {
+		for (Value v : scores) {
+			int16_t s16 = int16_t(v);
+			os.write(reinterpret_cast<const char*>(&s16), sizeof(s16));
+		}
+	} else {
+		for (Value v : scores) os << int(v) << '\n';
+	}
+	if (!os) {
+		sync_cout << "Unable to write '" << output << "'" << sync_endl;
+		return;
+	}
+
+	sync_cout << "Positions evaluated : " << positions.size() << std::endl
+	          << "Total time (ms)     : " << elapsed << std::endl
+	          << "Positions/second    : " << positions.size() * 1000 / elapsed << sync_endl;
+}
+
+std::string value(Value v) {
+	std::ostringstream ss;
+	if (v >= VALUE_MATE_IN_MAX_PLY) ss << "mate " << (VALUE_MATE - v + 1) / 2;
+	else if (v <= VALUE_MATED_IN_MAX_PLY) ss << "mate " << -(VALUE_MATE + v) / 2;
+	else ss << "cp " << int(v);
+	return ss.str();
+}
+
+void setoption(std::istringstream& ss, std::string& token) {
+	std::string name;
+	ss >> token >> name;
+	while (ss >> token && token != "value")
+		name = name + " " + token;
+	if (Options.count(name) == 0) {
+		std::cout << "Invalid option '" << name << "'" << std::endl;
+		return;
+	}
+	Option& op = Options[name];
+	if (op.type != "button") {
+		// "value" has already been consumed by the loop above
+		if (op.type == "spin") {
+			int value;
+			if ((ss >> value) && op.min <= value && value <= op.max) {
+				op.value = value;
+			}
+		} else if (op.type == "check") {
+			ss >> token;
+			std::transform(token.cbegin(), token.cend(), token.begin(),
+				[](unsigned char c){ return std::tolower(c); });
+			op.value = token;
+		} else {
+			// Strings keep their case and spaces, e.g. file names
+			std::string value;
+			std::getline(ss >> std::ws, value);
+			op.value = value;
+		}
+	}
+	if (op.on_change)
+		op.on_change(op);
+}
+
+int main(int argc, char **argv) {
+	Position pos;
+	StateListPtr dq(new std::deque<StateInfo>());
+
+	ucinewgame(pos, dq);
+
+	// "sephirah bench [depth]" runs the benchmark and exits
+	if (argc > 1 && std::string(argv[1]) == "bench") {
+		std::istringstream ss(argc > 2 ? argv[2] : "");
+		bench(ss, pos, dq);
+		return 0;
+	}
+
+	// "sephirah evalbatch <input> <output> [threads]" scores a file of
+	// positions and exits
+	if (argc > 1 && std::string(argv[1]) == "evalbatch") {
+		std::string args;
+		for (int i = 2; i < argc; ++i) args += std::string(argv[i]) + " ";
+		std::istringstream ss(args);
+		evalbatch(ss);
+		return 0;
+	}
+
+	std::cout << SEPHIRAH_NAME " " SEPHIRAH_VERSION " by " SEPHIRAH_AUTHOR << std::endl;
+	while (1) {
+		std::string cmd;
+		std::getline(std::cin, cmd);
+		std::istringstream ss(cmd);
+		std::string token;
+
+		if (!(ss >> std::skipws >> token)) {
+			continue;
+		}
+
+		if (token == "uci") uci();
+		else if (token == "isready") sync_cout << "readyok" << sync_endl;
+		else if (token == "setoption") setoption(ss, token);
+		else if (token == "ucinewgame") ucinewgame(pos, dq);
+		else if (token == "position") position(ss, pos, dq);
+		else if (token == "go") go(ss, pos, dq);
+		else if (token == "stop") Threads.stop();
+		else if (token == "ponderhit") Threads.ponderhit();
+		else if (token == "bench") bench(ss, pos, dq);
+		else if (token == "eval") sync_cout << Eval::trace(pos) << IO_UNLOCK;
+		else if (token == "evalbench") evalbench(ss);
+		else if (token == "evalbatch") evalbatch(ss);
+		else if (token == "quit") {
+			Threads.stop();
+			exit(0);
+		}
+		else  std::cout << "No such command '" << token << "'" << std::endl;
+	}
+	return 0;
+}
+
+}
@@ -1,10 +1,26 @@
-#ifndef UCI_H_INCLUDED
-#define UCI_H_INCLUDED
-
-namespace UCI {
-
-int main(int argc, char **argv);
-
-}
-
-#endif
+#ifndef UCI_H_INCLUDED
+#define UCI_H_INCLUDED
+
+#include <iostream>
+
+// Serialize output of the search and timer threads: use sync_cout << ... <<
+// sync_endl instead of std::cout so that lines are never interleaved.
+enum SyncCout { IO_LOCK, IO_UNLOCK };
+std::ostream& operator<<(std::ostream& os, SyncCout sc);
+
+#define sync_cout std::cout << IO_LOCK
+#define sync_endl std::endl << IO_UNLOCK
+
+#include "types.h"
+#include <string>
+
+namespace UCI {
+
+int main(int argc, char **argv);
+
+// Format a score for "info score": "cp <x>" or "mate <moves>"
+std::string value(Value v);
+
+}
+
+#endif
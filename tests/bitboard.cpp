@@ -1,39 +1,109 @@
-#include "bitboard.h"
-#include <gtest/gtest.h>
-
-TEST(Bitboard, PathHorizontalRight) {
-    Bitboard b = path_bb(SQ_A1, SQ_D1);
-    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_B1) | (1ULL << SQ_C1) | (1ULL << SQ_D1);
-    ASSERT_EQ(b, expected);
-}
-
-TEST(Bitboard, PathHorizontalLeft) {
-    Bitboard b = path_bb(SQ_D1, SQ_A1);
-    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_B1) | (1ULL << SQ_C1) | (1ULL << SQ_D1);
-    ASSERT_EQ(b, expected);
-}
-
-TEST(Bitboard, PathVerticalUp) {
-    Bitboard b = path_bb(SQ_A1, SQ_A4);
-    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_A2) | (1ULL << SQ_A3) | (1ULL << SQ_A4);
-    ASSERT_EQ(b, expected);
-}
-
-TEST(Bitboard, PathVerticalDown) {
-    Bitboard b = path_bb(SQ_A4, SQ_A1);
-    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_A2) | (1ULL << SQ_A3) | (1ULL << SQ_A4);
-    ASSERT_EQ(b, expected);
-}
-
-TEST(Bitboard, PathSingleSquare) {
-    Bitboard b = path_bb(SQ_E5, SQ_E5);
-    Bitboard expected = (1ULL << SQ_E5);
-    ASSERT_EQ(b, expected);
-}
-
-int main(int argc, char **argv)
-{
-	bitboard::init();
-	::testing::InitGoogleTest(&argc, argv);
-	return RUN_ALL_TESTS();
-}
+#include "bitboard.h"
+#include <gtest/gtest.h>
+
+TEST(Bitboard, PathHorizontalRight) {
+    Bitboard b = path_bb(SQ_A1, SQ_D1);
+    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_B1) | (1ULL << SQ_C1) | (1ULL << SQ_D1);
+    ASSERT_EQ(b, expected);
+}
+
+TEST(Bitboard, PathHorizontalLeft) {
+    Bitboard b = path_bb(SQ_D1, SQ_A1);
+    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_B1) | (1ULL << SQ_C1) | (1ULL << SQ_D1);
+    ASSERT_EQ(b, expected);
+}
+
+TEST(Bitboard, PathVerticalUp) {
+    Bitboard b = path_bb(SQ_A1, SQ_A4);
+    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_A2) | (1ULL << SQ_A3) | (1ULL << SQ_A4);
+    ASSERT_EQ(b, expected);
+}
+
+TEST(Bitboard, PathVerticalDown) {
+    Bitboard b = path_bb(SQ_A4, SQ_A1);
+    Bitboard expected = (1ULL << SQ_A1) | (1ULL << SQ_A2) | (1ULL << SQ_A3) | (1ULL << SQ_A4);
+    ASSERT_EQ(b, expected);
+}
+
+TEST(Bitboard, PathSingleSquare) {
+    Bitboard b = path_bb(SQ_E5, SQ_E5);
+    Bitboard expected = (1ULL << SQ_E5);
+    ASSERT_EQ(b, expected);
+}
+
+TEST(Bitboard, SlidingAttackEmptyBoard) {
+    ASSERT_EQ(__builtin_popcountll(PseudoAttacks[ROOK][SQ_D4]), 14);
+    ASSERT_EQ(__builtin_popcountll(PseudoAttacks[BISHOP][SQ_D4]), 13);
+    ASSERT_EQ(__builtin_popcountll(PseudoAttacks[BISHOP][SQ_A1]), 7);
+    ASSERT_EQ(PseudoAttacks[QUEEN][SQ_D4], PseudoAttacks[ROOK][SQ_D4] | PseudoAttacks[BISHOP][SQ_D4]);
+}
+
+TEST(Bitboard, SlidingAttackBlocked) {
+    Bitboard occupied = square_bb(SQ_D6) | square_bb(SQ_B4) | square_bb(SQ_F6);
+    Bitboard rook = attacks_bb(ROOK, SQ_D4, occupied);
+    Bitboard expected = square_bb(SQ_D5) | square_bb(SQ_D6)
+                      | square_bb(SQ_C4) | square_bb(SQ_B4)
+                      | square_bb(SQ_E4) | square_bb(SQ_F4) | square_bb(SQ_G4) | square_bb(SQ_H4)
+                      | square_bb(SQ_D3) | square_bb(SQ_D2) | square_bb(SQ_D1);
+    ASSERT_EQ(rook, expected);
+
+    Bitboard bishop = attacks_bb(BISHOP, SQ_D4, occupied);
+    ASSERT_TRUE(bishop & square_bb(SQ_F6));
+    ASSERT_FALSE(bishop & square_bb(SQ_G7));
+    ASSERT_TRUE(bishop & square_bb(SQ_A7));
+}
+
+TEST(Bitboard, MagicsMatchSlidingAttack) {
+    uint64_t seed = 1070372;
+    for (int i = 0; i < 1000; ++i) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        Bitboard occupied = seed & (seed >> 3);
+        for (Square sq = SQ_A1; sq <= SQ_H8; ++sq) {
+            ASSERT_EQ(attacks_bb(ROOK, sq, occupied), sliding_attack(ROOK, sq, occupied));
+            ASSERT_EQ(attacks_bb(BISHOP, sq, occupied), sliding_attack(BISHOP, sq, occupied));
+        }
+    }
+}
+
+TEST(Bitboard, PawnSpanTables) {
+    ASSERT_EQ(ForwardFileBB[WHITE][SQ_E4], square_bb(SQ_E5) | square_bb(SQ_E6) | square_bb(SQ_E7) | square_bb(SQ_E8));
+    ASSERT_EQ(ForwardFileBB[BLACK][SQ_E2], square_bb(SQ_E1));
+    ASSERT_EQ(PawnAttackSpan[BLACK][SQ_B3], square_bb(SQ_A2) | square_bb(SQ_C2) | square_bb(SQ_A1) | square_bb(SQ_C1));
+    ASSERT_EQ(__builtin_popcountll(PassedPawnMask[WHITE][SQ_D2]), 18);
+
+    // The set-wise fills agree with the tables
+    for (Color c : { WHITE, BLACK }) {
+        for (Square sq = SQ_A1; sq <= SQ_H8; ++sq) {
+            Bitboard front = front_span(c, square_bb(sq));
+            ASSERT_EQ(front, ForwardFileBB[c][sq]);
+            ASSERT_EQ(shift<EAST>(front) | shift<WEST>(front), PawnAttackSpan[c][sq]);
+            ASSERT_EQ(front | PawnAttackSpan[c][sq], PassedPawnMask[c][sq]);
+        }
+    }
+}
+
+TEST(Bitboard, PawnFills) {
+    ASSERT_EQ(AdjacentFilesBB[FILE_A], FileMask[FILE_B]);
+    ASSERT_EQ(adjacent_files_bb(FILE_E), FileMask[FILE_D] | FileMask[FILE_F]);
+    ASSERT_EQ(front_span(WHITE, square_bb(SQ_E4)), square_bb(SQ_E5) | square_bb(SQ_E6) | square_bb(SQ_E7) | square_bb(SQ_E8));
+    ASSERT_EQ(front_span(BLACK, square_bb(SQ_E2)), square_bb(SQ_E1));
+    ASSERT_EQ(file_fill(square_bb(SQ_C5)), FileMask[FILE_C]);
+
+    // The set-wise fills agree with square by square loops
+    for (Color c : { WHITE, BLACK }) {
+        Direction up = c == WHITE ? NORTH : SOUTH;
+        for (Square sq = SQ_A1; sq <= SQ_H8; ++sq) {
+            Bitboard front = 0;
+            for (int s = sq + up; s >= SQ_A1 && s <= SQ_H8; s += up) front |= square_bb(Square(s));
+            ASSERT_EQ(front_span(c, square_bb(sq)), front);
+            ASSERT_EQ(pawn_attacks_bb(c, square_bb(sq)), PawnAttacks[c][sq]);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+	bitboard::init();
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+#include "bitboard.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "position.h"
+#include "types.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+template<typename T>
+void put(std::ostream& os, T v) {
+	os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+// A network with small random weights, in the format of NNUE::save()
+std::string random_network() {
+	std::stringstream def;
+	NNUE::use_default();
+	NNUE::save(def);
+
+	std::mt19937 rng(12345);
+	auto rnd = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+	std::ostringstream os;
+	os << def.str().substr(0, 8); // header
+	for (int i = 0; i < NNUE::HalfDimensions; ++i) put(os, int16_t(rnd(0, 64)));
+	for (size_t i = 0; i < size_t(NNUE::Features) * NNUE::HalfDimensions; ++i) put(os, int16_t(rnd(-8, 8)));
+	for (size_t i = 0; i < size_t(NNUE::Features) * NNUE::PSQTBuckets; ++i) put(os, int32_t(rnd(-1000, 1000)));
+	for (int i = 0; i < NNUE::Hidden1; ++i) put(os, int32_t(rnd(-500, 500)));
+	for (int i = 0; i < NNUE::Hidden1 * 2 * NNUE::HalfDimensions; ++i) put(os, int8_t(rnd(-10, 10)));
+	for (int i = 0; i < NNUE::Hidden2; ++i) put(os, int32_t(rnd(-500, 500)));
+	for (int i = 0; i < NNUE::Hidden2 * NNUE::Hidden1; ++i) put(os, int8_t(rnd(-10, 10)));
+	put(os, int32_t(rnd(-500, 500)));
+	for (int i = 0; i < NNUE::Hidden2; ++i) put(os, int8_t(rnd(-10, 10)));
+	return os.str();
+}
+
+Value fresh_eval(const Position& pos) {
+	StateInfo st;
+	Position fresh;
+	fresh.set(pos.fen(), st);
+	return NNUE::evaluate(fresh);
+}
+
+} // namespace
+
+TEST(NNUE, load) {
+	std::string net = random_network();
+
+	std::istringstream truncated(net.substr(0, net.size() - 1));
+	ASSERT_FALSE(NNUE::load(truncated));
+
+	std::istringstream full(net);
+	ASSERT_TRUE(NNUE::load(full));
+
+	std::ostringstream saved;
+	ASSERT_TRUE(NNUE::save(saved));
+	ASSERT_EQ(saved.str(), net);
+}
+
+TEST(NNUE, incremental_accumulator) {
+	std::istringstream net(random_network());
+	ASSERT_TRUE(NNUE::load(net));
+
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", dq->back());
+	Value initial = NNUE::evaluate(pos);
+	ASSERT_EQ(initial, fresh_eval(pos));
+
+	// castling, captures, a double push with en passant, a promotion with
+	// capture and king moves, some of them not evaluated
+	const char* moves[] = { "e1g1", "h3g2", "a2a4", "b4a3", "d5e6", "g2f1q", "g1f1", "e8c8", "e6f7" };
+	int n = 0;
+	for (const char* m : moves) {
+		dq->emplace_back();
+		pos.do_move(pos.string_to_move(m), dq->back());
+		if (++n % 3 != 0) {
+			ASSERT_EQ(NNUE::evaluate(pos), fresh_eval(pos)) << "after " << m;
+		}
+	}
+	ASSERT_EQ(NNUE::evaluate(pos), fresh_eval(pos));
+
+	StateInfo st;
+	pos.do_null_move(st);
+	ASSERT_EQ(NNUE::evaluate(pos), fresh_eval(pos));
+	pos.undo_null_move();
+
+	for (size_t i = 0; i < sizeof(moves) / sizeof(moves[0]); ++i) {
+		pos.undo_move();
+	}
+	ASSERT_EQ(NNUE::evaluate(pos), initial);
+}
+
+TEST(NNUE, default_network) {
+	NNUE::use_default();
+
+	StateInfo st;
+	Position pos;
+	pos.set("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", st);
+	ASSERT_EQ(NNUE::evaluate(pos), VALUE_ZERO);
+
+	// Material and piece-square score of the middlegame
+	pos.set("rnb1kbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1", st);
+	ASSERT_EQ(NNUE::evaluate(pos), -mg_value(pos.psq_score()));
+}
+
+int main(int argc, char **argv)
+{
+	bitboard::init();
+	PSQT::init();
+	Position::init();
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,177 +1,422 @@
-#include "bitboard.h"
-#include "types.h"
-#include "position.h"
-#include <gtest/gtest.h>
-#include <string>
-
-TEST(Position, initialState) {
-	const std::string initialFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-
-	StateListPtr dq(new std::deque<StateInfo>());
-	dq->emplace_back();
-	Position pos;
-	pos.set(initialFEN, dq->back());
-
-	for (Square i = SQ_A1; i < SQ_NB; ++i) {
-		switch (i) {
-			// White back rank
-			case SQ_A1: ASSERT_EQ(pos.piece_on(i), W_ROOK); break;
-			case SQ_B1: ASSERT_EQ(pos.piece_on(i), W_KNIGHT); break;
-			case SQ_C1: ASSERT_EQ(pos.piece_on(i), W_BISHOP); break;
-			case SQ_D1: ASSERT_EQ(pos.piece_on(i), W_QUEEN); break;
-			case SQ_E1: ASSERT_EQ(pos.piece_on(i), W_KING); break;
-			case SQ_F1: ASSERT_EQ(pos.piece_on(i), W_BISHOP); break;
-			case SQ_G1: ASSERT_EQ(pos.piece_on(i), W_KNIGHT); break;
-			case SQ_H1: ASSERT_EQ(pos.piece_on(i), W_ROOK); break;
-
-			// White pawns
-			case SQ_A2: case SQ_B2: case SQ_C2: case SQ_D2:
-			case SQ_E2: case SQ_F2: case SQ_G2: case SQ_H2:
-				ASSERT_EQ(pos.piece_on(i), W_PAWN);
-				break;
-
-			// Black back rank
-			case SQ_A8: ASSERT_EQ(pos.piece_on(i), B_ROOK); break;
-			case SQ_B8: ASSERT_EQ(pos.piece_on(i), B_KNIGHT); break;
-			case SQ_C8: ASSERT_EQ(pos.piece_on(i), B_BISHOP); break;
-			case SQ_D8: ASSERT_EQ(pos.piece_on(i), B_QUEEN); break;
-			case SQ_E8: ASSERT_EQ(pos.piece_on(i), B_KING); break;
-			case SQ_F8: ASSERT_EQ(pos.piece_on(i), B_BISHOP); break;
-			case SQ_G8: ASSERT_EQ(pos.piece_on(i), B_KNIGHT); break;
-			case SQ_H8: ASSERT_EQ(pos.piece_on(i), B_ROOK); break;
-
-			// Black pawns
-			case SQ_A7: case SQ_B7: case SQ_C7: case SQ_D7:
-			case SQ_E7: case SQ_F7: case SQ_G7: case SQ_H7:
-				ASSERT_EQ(pos.piece_on(i), B_PAWN);
-				break;
-
-			// Empty squares
-			default:
-				ASSERT_EQ(pos.piece_on(i), NO_PIECE);
-				break;
-		}
-	}
-
-	// Optional: check side to move
-	ASSERT_EQ(pos.side_to_move(), WHITE);
-
-	// Optional: castling rights
-	// ASSERT_TRUE(pos.can_castle_kingside(WHITE));
-	// ASSERT_TRUE(pos.can_castle_queenside(WHITE));
-	// ASSERT_TRUE(pos.can_castle_kingside(BLACK));
-	// ASSERT_TRUE(pos.can_castle_queenside(BLACK));
-
-	// Optional: en passant square
-	ASSERT_EQ(pos.ep_square(), SQ_NONE);
-}
-
-void dfs(Position& p, int cur_d, int cnt[], StateListPtr& dq, const int MAXD) {
-	++cnt[cur_d];
-	if (cur_d + 1 >= MAXD) return;
-
-	svec<Move> moves;
-	p.generate_moves(moves);
-
-	for (Move m : moves) {
-		dq->emplace_back();
-
-		p.do_move(m, dq->back());
-		dfs(p, cur_d + 1, cnt, dq, MAXD);
-		p.undo_move();
-		dq->pop_back();
-	}
-}
-
-void perft_(const int perft_cnt[], const int MAXD, const std::string initialFEN) {
-	StateListPtr dq(new std::deque<StateInfo>());
-	dq->emplace_back();
-	Position pos;
-	pos.set(initialFEN, dq->back());
-
-	int cnt[100]; memset(cnt, 0, sizeof(cnt));
-	dfs(pos, 0, cnt, dq, MAXD);
-	for (int i = 0; i < MAXD; ++i) {
-		std::cout << perft_cnt[i] << ' ' << cnt[i] << '\n';
-		ASSERT_EQ(perft_cnt[i], cnt[i]);
-	}
-}
-
-TEST(Position, perft_1) {
-	const int perft_cnt[] = { 1, 20, 400, 8902, 197281, 4865609 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_2) {
-	const int perft_cnt[] = { 1, 48, 2039, 97862, 4085603 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_3) {
-	const int perft_cnt[] = { 1, 14, 191, 2812, 43238 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_4) {
-	const int perft_cnt[] = { 1, 6, 264, 9467, 422333, 15833292 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_4_mirrored) {
-	const int perft_cnt[] = { 1, 6, 264, 9467, 422333, 15833292 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_5) {
-	const int perft_cnt[] = { 1, 44, 1486, 62379, 2103487 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, perft_6) {
-	const int perft_cnt[] = { 1, 46, 2079, 89890, 3894594 };
-	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10";
-	perft_(perft_cnt, MAXD, initialFEN);
-}
-
-TEST(Position, castling) {
-	// const int perft_cnt[] = { 1, 48, 2039, 97862, 4085603 };
-	// const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
-	const std::string initialFEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
-
-	StateListPtr dq(new std::deque<StateInfo>());
-	dq->emplace_back();
-	Position pos;
-	pos.set(initialFEN, dq->back());
-
-	Move m = make_move(SQ_E1, SQ_G1);
-	m |= CASTLING;
-	
-	pos.print_board();
-	dq->emplace_back();
-	pos.do_move(m, dq->back());
-	pos.print_board();
-
-	pos.undo_move();
-	pos.print_board();
-}
-
-int main(int argc, char **argv)
-{
-	bitboard::init();
-	Position::init();
-	::testing::InitGoogleTest(&argc, argv);
-	return RUN_ALL_TESTS();
-}
+#include "bitboard.h"
+#include "endgame.h"
+#include "evaluation.h"
+#include "types.h"
+#include "position.h"
+#include <cctype>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(Position, initialState) {
+	const std::string initialFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set(initialFEN, dq->back());
+
+	for (Square i = SQ_A1; i < SQ_NB; ++i) {
+		switch (i) {
+			// White back rank
+			case SQ_A1: ASSERT_EQ(pos.piece_on(i), W_ROOK); break;
+			case SQ_B1: ASSERT_EQ(pos.piece_on(i), W_KNIGHT); break;
+			case SQ_C1: ASSERT_EQ(pos.piece_on(i), W_BISHOP); break;
+			case SQ_D1: ASSERT_EQ(pos.piece_on(i), W_QUEEN); break;
+			case SQ_E1: ASSERT_EQ(pos.piece_on(i), W_KING); break;
+			case SQ_F1: ASSERT_EQ(pos.piece_on(i), W_BISHOP); break;
+			case SQ_G1: ASSERT_EQ(pos.piece_on(i), W_KNIGHT); break;
+			case SQ_H1: ASSERT_EQ(pos.piece_on(i), W_ROOK); break;
+
+			// White pawns
+			case SQ_A2: case SQ_B2: case SQ_C2: case SQ_D2:
+			case SQ_E2: case SQ_F2: case SQ_G2: case SQ_H2:
+				ASSERT_EQ(pos.piece_on(i), W_PAWN);
+				break;
+
+			// Black back rank
+			case SQ_A8: ASSERT_EQ(pos.piece_on(i), B_ROOK); break;
+			case SQ_B8: ASSERT_EQ(pos.piece_on(i), B_KNIGHT); break;
+			case SQ_C8: ASSERT_EQ(pos.piece_on(i), B_BISHOP); break;
+			case SQ_D8: ASSERT_EQ(pos.piece_on(i), B_QUEEN); break;
+			case SQ_E8: ASSERT_EQ(pos.piece_on(i), B_KING); break;
+			case SQ_F8: ASSERT_EQ(pos.piece_on(i), B_BISHOP); break;
+			case SQ_G8: ASSERT_EQ(pos.piece_on(i), B_KNIGHT); break;
+			case SQ_H8: ASSERT_EQ(pos.piece_on(i), B_ROOK); break;
+
+			// Black pawns
+			case SQ_A7: case SQ_B7: case SQ_C7: case SQ_D7:
+			case SQ_E7: case SQ_F7: case SQ_G7: case SQ_H7:
+				ASSERT_EQ(pos.piece_on(i), B_PAWN);
+				break;
+
+			// Empty squares
+			default:
+				ASSERT_EQ(pos.piece_on(i), NO_PIECE);
+				break;
+		}
+	}
+
+	// Optional: check side to move
+	ASSERT_EQ(pos.side_to_move(), WHITE);
+
+	// Optional: castling rights
+	// ASSERT_TRUE(pos.can_castle_kingside(WHITE));
+	// ASSERT_TRUE(pos.can_castle_queenside(WHITE));
+	// ASSERT_TRUE(pos.can_castle_kingside(BLACK));
+	// ASSERT_TRUE(pos.can_castle_queenside(BLACK));
+
+	// Optional: en passant square
+	ASSERT_EQ(pos.ep_square(), SQ_NONE);
+}
+
+void dfs(Position& p, int cur_d, int cnt[], StateListPtr& dq, const int MAXD) {
+	++cnt[cur_d];
+	if (cur_d + 1 >= MAXD) return;
+
+	svec<Move> moves;
+	p.generate_moves(moves);
+
+	for (Move m : moves) {
+		dq->emplace_back();
+
+		p.do_move(m, dq->back());
+		dfs(p, cur_d + 1, cnt, dq, MAXD);
+		p.undo_move();
+		dq->pop_back();
+	}
+}
+
+void perft_(const int perft_cnt[], const int MAXD, const std::string initialFEN) {
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set(initialFEN, dq->back());
+
+	int cnt[100]; memset(cnt, 0, sizeof(cnt));
+	dfs(pos, 0, cnt, dq, MAXD);
+	for (int i = 0; i < MAXD; ++i) {
+		std::cout << perft_cnt[i] << ' ' << cnt[i] << '\n';
+		ASSERT_EQ(perft_cnt[i], cnt[i]);
+	}
+}
+
+TEST(Position, perft_1) {
+	const int perft_cnt[] = { 1, 20, 400, 8902, 197281, 4865609 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_2) {
+	const int perft_cnt[] = { 1, 48, 2039, 97862, 4085603 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_3) {
+	const int perft_cnt[] = { 1, 14, 191, 2812, 43238 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_4) {
+	const int perft_cnt[] = { 1, 6, 264, 9467, 422333, 15833292 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_4_mirrored) {
+	const int perft_cnt[] = { 1, 6, 264, 9467, 422333, 15833292 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_5) {
+	const int perft_cnt[] = { 1, 44, 1486, 62379, 2103487 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, perft_6) {
+	const int perft_cnt[] = { 1, 46, 2079, 89890, 3894594 };
+	const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10";
+	perft_(perft_cnt, MAXD, initialFEN);
+}
+
+TEST(Position, castling) {
+	// const int perft_cnt[] = { 1, 48, 2039, 97862, 4085603 };
+	// const int MAXD = sizeof(perft_cnt) / sizeof(perft_cnt[0]);
+	const std::string initialFEN = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set(initialFEN, dq->back());
+
+	Move m = make_move(SQ_E1, SQ_G1);
+	m |= CASTLING;
+	
+	pos.print_board();
+	dq->emplace_back();
+	pos.do_move(m, dq->back());
+	pos.print_board();
+
+	pos.undo_move();
+	pos.print_board();
+}
+
+TEST(Position, see) {
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+
+	// Rook takes an undefended pawn
+	pos.set("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", dq->back());
+	ASSERT_TRUE(pos.see_ge(make_move(SQ_E1, SQ_E5)));
+	ASSERT_TRUE(pos.see_ge(make_move(SQ_E1, SQ_E5), PawnValueMg));
+	ASSERT_FALSE(pos.see_ge(make_move(SQ_E1, SQ_E5), Value(PawnValueMg + 1)));
+
+	// Knight takes a pawn defended by a pawn
+	pos.set("4k3/8/3p4/4p3/8/3N4/8/4K3 w - - 0 1", dq->back());
+	ASSERT_FALSE(pos.see_ge(make_move(SQ_D3, SQ_E5)));
+	ASSERT_TRUE(pos.see_ge(make_move(SQ_D3, SQ_E5), Value(PawnValueMg - KnightValueMg)));
+
+	// Rook takes a pawn defended by a rook, with a second rook x-raying
+	pos.set("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1", dq->back());
+	ASSERT_TRUE(pos.see_ge(make_move(SQ_E2, SQ_E5)));
+	ASSERT_FALSE(pos.see_ge(make_move(SQ_E2, SQ_E5), Value(PawnValueMg + 1)));
+
+	// Quiet moves to a safe square and to a square attacked by a pawn
+	pos.set("4k3/8/8/4p3/8/8/8/2B1K3 w - - 0 1", dq->back());
+	ASSERT_TRUE(pos.see_ge(make_move(SQ_C1, SQ_E3)));
+	ASSERT_FALSE(pos.see_ge(make_move(SQ_C1, SQ_F4)));
+}
+
+TEST(Position, repetition) {
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", dq->back());
+
+	const Move moves[] = {
+		make_move(SQ_G1, SQ_F3), make_move(SQ_G8, SQ_F6),
+		make_move(SQ_F3, SQ_G1), make_move(SQ_F6, SQ_G8),
+	};
+
+	dq->emplace_back();
+	pos.do_move(moves[0], dq->back());
+	ASSERT_FALSE(pos.has_game_cycle(10));
+	dq->emplace_back();
+	pos.do_move(moves[1], dq->back());
+	dq->emplace_back();
+	pos.do_move(moves[2], dq->back());
+
+	// Nf6-g8 repeats the initial position, but not before the root
+	ASSERT_TRUE(pos.has_game_cycle(10));
+	ASSERT_FALSE(pos.has_game_cycle(0));
+	ASSERT_FALSE(pos.is_draw());
+
+	dq->emplace_back();
+	pos.do_move(moves[3], dq->back());
+	ASSERT_TRUE(pos.is_draw());
+}
+
+TEST(Position, incremental_psq) {
+	StateListPtr dq(new std::deque<StateInfo>());
+	dq->emplace_back();
+	Position pos;
+	pos.set("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", dq->back());
+
+	// castling, captures, a double push with en passant and a promotion
+	const char* moves[] = { "e1g1", "h3g2", "a2a4", "b4a3", "d5e6", "g2f1q", "e6f7" };
+	for (const char* m : moves) {
+		dq->emplace_back();
+		pos.do_move(pos.string_to_move(m), dq->back());
+
+		StateInfo st;
+		Position fresh;
+		fresh.set(pos.fen(), st);
+		ASSERT_EQ(pos.key(), fresh.key());
+		ASSERT_EQ(pos.pawn_key(), fresh.pawn_key());
+		ASSERT_EQ(pos.material_key(), fresh.material_key());
+		ASSERT_EQ(pos.psq_score(), fresh.psq_score());
+		ASSERT_EQ(pos.non_pawn_material(WHITE), fresh.non_pawn_material(WHITE));
+		ASSERT_EQ(pos.non_pawn_material(BLACK), fresh.non_pawn_material(BLACK));
+	}
+
+	StateInfo st;
+	Position initial;
+	initial.set("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", st);
+	for (size_t i = 0; i < sizeof(moves) / sizeof(moves[0]); ++i) {
+		pos.undo_move();
+	}
+	ASSERT_EQ(pos.psq_score(), initial.psq_score());
+	ASSERT_NE(pos.psq_score(), SCORE_ZERO);
+}
+
+// Same position with the colors swapped and the board flipped
+std::string flip_fen(const std::string& fen) {
+	std::istringstream ss(fen);
+	std::string board, side, castling, ep, rest;
+	ss >> board >> side >> castling >> ep;
+	std::getline(ss, rest);
+
+	std::string flipped;
+	size_t end = board.size();
+	for (size_t slash = board.rfind('/'); ; slash = board.rfind('/', slash - 1)) {
+		size_t begin = slash == std::string::npos ? 0 : slash + 1;
+		flipped += board.substr(begin, end - begin) + (begin ? "/" : "");
+		if (!begin) break;
+		end = slash;
+	}
+	auto swap_case = [](std::string str) {
+		for (char& c : str) c = std::isupper(c) ? std::tolower(c) : std::toupper(c);
+		return str;
+	};
+	if (ep != "-") ep[1] = ep[1] == '3' ? '6' : '3';
+	return swap_case(flipped) + (side == "w" ? " b " : " w ") + swap_case(castling) + " " + ep + rest;
+}
+
+TEST(Position, eval_symmetry) {
+	const char* fens[] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"2r3k1/1q3ppp/p3p3/1p1nP3/3P4/P4N2/1B3PPP/2RQ2K1 b - - 0 25",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"8/8/4k3/8/2P5/8/5K2/3r4 w - - 0 1",
+	};
+	for (const char* fen : fens) {
+		StateInfo st1, st2;
+		Position pos, flipped;
+		pos.set(fen, st1);
+		flipped.set(flip_fen(fen), st2);
+		ASSERT_EQ(eval(pos), eval(flipped)) << fen;
+	}
+}
+
+TEST(Position, lazy_eval) {
+	StateInfo st;
+	Position pos;
+	// White is a queen up
+	pos.set("rnb1kbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", st);
+	Value full = eval(pos);
+
+	// A window around the full value, or a wide one, gets the full value
+	ASSERT_EQ(eval(pos, Value(full - 1), Value(full + 1)), full);
+	ASSERT_EQ(eval(pos, -VALUE_INFINITE, VALUE_INFINITE), full);
+
+	// Far outside the window, the early value is on the same side of it
+	ASSERT_GT(eval(pos, Value(-100), Value(-50)), Value(-50));
+	ASSERT_LT(eval(pos, Value(6000), Value(6050)), Value(6000));
+
+	// and is reported as lazy, unlike the full value
+	bool lazy = true;
+	eval(pos, Value(full - 1), Value(full + 1), lazy);
+	ASSERT_FALSE(lazy);
+	eval(pos, Value(-100), Value(-50), lazy);
+	ASSERT_TRUE(lazy);
+}
+
+TEST(Position, eval_trace) {
+	StateInfo st;
+	Position pos;
+	pos.set("r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8", st);
+	std::string trace = Eval::trace(pos);
+	ASSERT_NE(trace.find("King safety"), std::string::npos);
+	ASSERT_NE(trace.find("Tempo |     20    20 |      0     0 |     20    20"), std::string::npos);
+	ASSERT_NE(trace.find("Classical evaluation: " + std::to_string(eval(pos)) + " "), std::string::npos);
+
+	std::istringstream epd("8/8/3k4/8/8/3NN3/3K4/8 w - - bm Kd3;\n"
+	                       "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8\n");
+	ASSERT_NE(Eval::profile(epd, 1).find("Positions: 2,"), std::string::npos);
+}
+
+TEST(Position, packed) {
+	const std::vector<std::string> fens = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b Kq - 3 17",
+		"8/8/3k4/8/8/3NN3/3K4/8 w - - 12 60",
+	};
+
+	std::vector<PackedPosition> packed;
+	std::vector<Value> expected;
+	for (const std::string& fen : fens) {
+		StateInfo st1, st2;
+		Position a, b;
+		a.set(fen, st1);
+		b.set(a.pack(), st2);
+		ASSERT_EQ(b.fen(), a.fen());
+		ASSERT_EQ(b.rule50(), a.rule50());
+		ASSERT_EQ(b.game_ply(), a.game_ply());
+		ASSERT_EQ(b.key(), a.key());
+		ASSERT_EQ(b.pawn_key(), a.pawn_key());
+		ASSERT_EQ(b.material_key(), a.material_key());
+		packed.push_back(a.pack());
+		expected.push_back(eval(a));
+	}
+
+	// Several blocks, shared by more threads than there are blocks
+	std::vector<PackedPosition> batch;
+	std::vector<Value> batchExpected;
+	for (size_t i = 0; i < 3 * Eval::BatchBlock + 5; ++i) {
+		batch.push_back(packed[i % packed.size()]);
+		batchExpected.push_back(expected[i % packed.size()]);
+	}
+	std::vector<Value> scores(batch.size(), VALUE_NONE);
+	Eval::evaluate_batch(batch.data(), batch.size(), scores.data(), 6);
+	ASSERT_EQ(scores, batchExpected);
+}
+
+TEST(Position, endgames) {
+	auto evaluate = [](const std::string& fen) {
+		StateInfo st;
+		Position pos;
+		pos.set(fen, st);
+		return eval(pos);
+	};
+
+	// Known draws and wins, from the side to move
+	ASSERT_EQ(evaluate("8/8/3k4/8/8/3NN3/3K4/8 w - - 0 1"), VALUE_DRAW);
+	ASSERT_GT(evaluate("8/8/3k4/8/8/3BN3/3K4/8 w - - 0 1"), VALUE_KNOWN_WIN);
+	ASSERT_LT(evaluate("8/8/3k4/8/8/3BN3/3K4/8 b - - 0 1"), -VALUE_KNOWN_WIN);
+	ASSERT_GT(evaluate("8/8/3k4/8/8/4R3/3K4/8 w - - 0 1"), VALUE_KNOWN_WIN);
+
+	// A stalemated lone king is a draw, not a won position
+	ASSERT_EQ(evaluate("k7/8/1Q6/8/8/8/8/7K b - - 0 1"), VALUE_DRAW);
+	ASSERT_EQ(evaluate("8/8/8/8/8/8/1R6/k1K5 b - - 0 1"), VALUE_DRAW);
+	ASSERT_GT(evaluate("k7/8/1Q6/8/8/8/8/7K w - - 0 1"), VALUE_KNOWN_WIN);
+	ASSERT_LT(evaluate("k7/8/2Q5/8/8/8/8/7K b - - 0 1"), -VALUE_KNOWN_WIN);
+	ASSERT_LT(evaluate("8/8/3k4/3b4/8/4R3/3K4/8 w - - 0 1"), Value(PawnValueEg));
+
+	// The bishop and knight mate happens in a corner of the bishop's color
+	ASSERT_GT(evaluate("7k/8/8/8/8/8/8/B1N1K3 w - - 0 1"), evaluate("k7/8/8/8/8/8/8/B1N1K3 w - - 0 1"));
+
+	// A lone knight cannot win
+	ASSERT_LE(evaluate("8/8/3k4/8/8/3N4/3K4/8 w - - 0 1"), Value(20));
+
+	// The material key does not depend on the squares of the pieces
+	StateInfo st1, st2;
+	Position a, b;
+	a.set("8/8/3k4/8/8/3BN3/3K4/8 w - - 0 1", st1);
+	b.set("7k/8/8/8/8/8/8/B1N1K3 b - - 0 1", st2);
+	ASSERT_EQ(a.material_key(), b.material_key());
+}
+
+int main(int argc, char **argv)
+{
+	bitboard::init();
+	PSQT::init();
+	Position::init();
+	Endgames::init();
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
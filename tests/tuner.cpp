@@ -0,0 +1,110 @@
+#include "bitboard.h"
+#include "endgame.h"
+#include "evaluation.h"
+#include "position.h"
+#include "tune.h"
+#include "types.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char* Game =
+	"[Event \"?\"]\n"
+	"[White \"Sephirah\"]\n"
+	"[Black \"SF2000\"]\n"
+	"[Result \"0-1\"]\n"
+	"\n"
+	"1. Nf3 {+0.29/11 3.0s} d6 {-0.22/22 4.0s} 2. e3 e5 3. Bc4 e4 4. Nd4 d5 5. Be2\n"
+	"Nf6 6. Bb5+ Nfd7 7. Nc3 a6 8. Bxd7+ Nxd7 9. Kf1 Ne5 10. Qh5 Bd6 11. h3\n"
+	"c5 12. Nb3 b5 13. Nxd5 Be6 14. f4 exf3 15. Nc3 (15. Nf4 Bxf4) b4 16. Ne4 fxg2+\n"
+	"17. Kxg2 O-O 18. Nxd6 f5 19. d4 cxd4 20. Rf1 Qxd6 21. Nxd4 Rf6 22. Nxe6 Rxe6\n"
+	"23. Kg1 Rg6+ 24. Kf2 b3 25. Ke1 Rd8 26. axb3 Qb4+ 27. Ke2 Qc5 28. Ke1 Qxc2\n"
+	"29. Qe2 Nd3+ 30. Qxd3 Rxd3 31. Rxa6 Rd1# {Black mates} 0-1\n";
+
+} // namespace
+
+TEST(Tune, linearize) {
+	const char* fens[] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"2r3k1/1q3ppp/p3p3/1p1nP3/3P4/P4N2/1B3PPP/2RQ2K1 b - - 0 25",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r1b2rk1/2q1bppp/p2ppn2/1p6/3BP3/1BN5/PPP2PPP/R2Q1RK1 w - - 0 13",
+	};
+	Tune::Weights weights;
+	for (const char* fen : fens) {
+		StateInfo st;
+		Position pos;
+		pos.set(fen, st);
+
+		Tune::DataSet data;
+		ASSERT_TRUE(Tune::add_position(pos, 0.5f, data));
+
+		// The evaluation without the tempo bonus, from White's point of view
+		Value v = eval(pos) - Eval::Tempo;
+		if (pos.side_to_move() == BLACK) v = -v;
+		ASSERT_NEAR(Tune::evaluate(data, data.entries[0], weights), double(v), 1.0) << fen;
+	}
+
+	// Specialized endgames do not use the weights
+	StateInfo st;
+	Position pos;
+	pos.set("8/8/3k4/8/8/3BN3/3K4/8 w - - 0 1", st);
+	Tune::DataSet data;
+	ASSERT_FALSE(Tune::add_position(pos, 1.0f, data));
+	ASSERT_TRUE(data.entries.empty());
+}
+
+TEST(Tune, read_pgn) {
+	std::istringstream pgn(std::string(Game) + "\n" + Game);
+	Tune::DataSet data;
+	ASSERT_EQ(Tune::read_pgn(pgn, data), 2);
+	ASSERT_FALSE(data.entries.empty());
+	ASSERT_EQ(data.entries.size() % 2, 0u);
+	for (const Tune::Entry& e : data.entries) ASSERT_EQ(e.result, 0.0f);
+
+	// An illegal move drops the game
+	std::string bad = Game;
+	bad.replace(bad.find("Kxg2"), 4, "Kxh2");
+	std::istringstream badPgn(bad);
+	Tune::DataSet none;
+	ASSERT_EQ(Tune::read_pgn(badPgn, none), 0);
+}
+
+TEST(Tune, optimize) {
+	std::istringstream pgn(Game);
+	Tune::DataSet data;
+	Tune::read_pgn(pgn, data);
+
+	Tune::Weights weights;
+	double K = Tune::find_k(data, weights, 2);
+	double before = Tune::error(data, weights, K, 2);
+	Tune::optimize(data, weights, K, 20, 2, 0);
+	ASSERT_LT(Tune::error(data, weights, K, 2), before);
+}
+
+TEST(Tune, write_header) {
+	// The compiled-in weights give back weights.h
+	std::ifstream file(SEPHIRAH_SOURCE_DIR "/src/weights.h");
+	ASSERT_TRUE(file);
+	std::stringstream expected;
+	expected << file.rdbuf();
+
+	std::ostringstream header;
+	Tune::write_header(header, Tune::Weights());
+	ASSERT_EQ(header.str(), expected.str());
+}
+
+int main(int argc, char **argv)
+{
+	bitboard::init();
+	PSQT::init();
+	Position::init();
+	Endgames::init();
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}